@@ -0,0 +1,110 @@
+#include "AllocationCounter.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+#if defined(_MSC_VER)
+#include <malloc.h>
+#endif
+
+namespace
+{
+	std::atomic<uint64_t> g_AllocationCount{};
+
+	//Memory of the aligned operator new has to go back through the matching free, msvc has no aligned_alloc
+	void FreeAligned(void* pMemory)
+	{
+#if defined(_MSC_VER)
+		_aligned_free(pMemory);
+#else
+		std::free(pMemory);
+#endif
+	}
+}
+
+uint64_t dae::AllocationCounter::GetCount()
+{
+	return g_AllocationCount.load(std::memory_order_relaxed);
+}
+
+//Replacements of the global operator new/delete, the array and nothrow versions forward to these by default
+void* operator new(std::size_t size)
+{
+	g_AllocationCount.fetch_add(1, std::memory_order_relaxed);
+
+	//malloc(0) may return nullptr, new may not
+	if (void* pMemory{ std::malloc(size ? size : 1) })
+		return pMemory;
+
+	throw std::bad_alloc{};
+}
+
+void* operator new[](std::size_t size)
+{
+	return ::operator new(size);
+}
+
+void operator delete(void* pMemory) noexcept
+{
+	std::free(pMemory);
+}
+
+void operator delete[](void* pMemory) noexcept
+{
+	std::free(pMemory);
+}
+
+void operator delete(void* pMemory, std::size_t) noexcept
+{
+	std::free(pMemory);
+}
+
+void operator delete[](void* pMemory, std::size_t) noexcept
+{
+	std::free(pMemory);
+}
+
+//Types aligned beyond what new guarantees, like cache line aligned ones, come through these instead and count the same
+void* operator new(std::size_t size, std::align_val_t alignment)
+{
+	g_AllocationCount.fetch_add(1, std::memory_order_relaxed);
+
+	const std::size_t alignmentSize{ static_cast<std::size_t>(alignment) };
+	const std::size_t allocationSize{ size ? size : 1 };
+#if defined(_MSC_VER)
+	void* pMemory{ _aligned_malloc(allocationSize, alignmentSize) };
+#else
+	//aligned_alloc only takes sizes that are a multiple of the alignment
+	void* pMemory{ std::aligned_alloc(alignmentSize, (allocationSize + alignmentSize - 1) / alignmentSize * alignmentSize) };
+#endif
+	if (pMemory)
+		return pMemory;
+
+	throw std::bad_alloc{};
+}
+
+void* operator new[](std::size_t size, std::align_val_t alignment)
+{
+	return ::operator new(size, alignment);
+}
+
+void operator delete(void* pMemory, std::align_val_t) noexcept
+{
+	FreeAligned(pMemory);
+}
+
+void operator delete[](void* pMemory, std::align_val_t) noexcept
+{
+	FreeAligned(pMemory);
+}
+
+void operator delete(void* pMemory, std::size_t, std::align_val_t) noexcept
+{
+	FreeAligned(pMemory);
+}
+
+void operator delete[](void* pMemory, std::size_t, std::align_val_t) noexcept
+{
+	FreeAligned(pMemory);
+}
@@ -0,0 +1,13 @@
+#pragma once
+
+//Standard includes
+#include <cstdint>
+
+namespace dae
+{
+	namespace AllocationCounter
+	{
+		//Number of calls to the global operator new since the start of the program, on every thread
+		uint64_t GetCount();
+	}
+}
@@ -0,0 +1,619 @@
+#include "Benchmark.h"
+#include "Camera.h"
+#include "CpuFeatures.h"
+#include "MeshFile.h"
+#include "Renderer.h"
+#include "ThreadPool.h"
+#include "Timer.h"
+#include "Utils.h"
+#include "VertexKernels.h"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace dae
+{
+	namespace
+	{
+		//Hardware cache miss counter of the calling thread, only available through perf events on linux
+		//Elsewhere IsValid returns false and a profiler like VTune has to be used instead
+		class CacheMissCounter final
+		{
+		public:
+			CacheMissCounter()
+			{
+#if defined(__linux__)
+				perf_event_attr attributes{};
+				attributes.type = PERF_TYPE_HARDWARE;
+				attributes.size = sizeof(perf_event_attr);
+				attributes.config = PERF_COUNT_HW_CACHE_MISSES;
+				attributes.disabled = 1;
+				attributes.exclude_kernel = 1;
+				attributes.exclude_hv = 1;
+
+				m_FileDescriptor = static_cast<int>(syscall(__NR_perf_event_open, &attributes, 0, -1, -1, 0));
+#endif
+			}
+
+			~CacheMissCounter()
+			{
+#if defined(__linux__)
+				if (IsValid())
+					close(m_FileDescriptor);
+#endif
+			}
+
+			CacheMissCounter(const CacheMissCounter&) = delete;
+			CacheMissCounter(CacheMissCounter&&) noexcept = delete;
+			CacheMissCounter& operator=(const CacheMissCounter&) = delete;
+			CacheMissCounter& operator=(CacheMissCounter&&) noexcept = delete;
+
+			bool IsValid() const { return m_FileDescriptor >= 0; };
+
+			void Start()
+			{
+#if defined(__linux__)
+				if (!IsValid())
+					return;
+
+				ioctl(m_FileDescriptor, PERF_EVENT_IOC_RESET, 0);
+				ioctl(m_FileDescriptor, PERF_EVENT_IOC_ENABLE, 0);
+#endif
+			}
+
+			uint64_t Stop()
+			{
+				uint64_t count{};
+#if defined(__linux__)
+				if (!IsValid())
+					return count;
+
+				ioctl(m_FileDescriptor, PERF_EVENT_IOC_DISABLE, 0);
+				if (read(m_FileDescriptor, &count, sizeof(count)) != sizeof(count))
+					count = 0;
+#endif
+				return count;
+			}
+
+		private:
+			int m_FileDescriptor{ -1 };
+		};
+
+		//Quad that just fits inside the frustum of the default camera, so every pixel gets rasterized
+		Mesh CreateFullScreenQuad()
+		{
+			const float depth{ 10.f };
+			const float halfHeight{ 4.1f };
+			const float halfWidth{ 5.5f };
+
+			Mesh quad
+			{
+				{
+					Vertex{{ -halfWidth, halfHeight, depth }, {0, 0, 0}, { 0.0f, 0.0f }},
+					Vertex{{ halfWidth, halfHeight, depth }, {0, 0, 0}, { 1.0f, 0.0f }},
+					Vertex{{ -halfWidth, -halfHeight, depth }, {0, 0, 0}, { 0.0f, 1.0f }},
+					Vertex{{ halfWidth, -halfHeight, depth }, {0, 0, 0}, { 1.0f, 1.0f }}
+				},
+				{
+					0, 1, 2,
+					2, 1, 3
+				},
+				PrimitiveTopology::TriangeList
+			};
+
+			return quad;
+		}
+
+		Mesh CreateVehicle()
+		{
+			Mesh vehicle{};
+			Utils::ParseOBJ("Resources/vehicle.obj", vehicle.vertices, vehicle.indices);
+
+			vehicle.primitiveTopology = PrimitiveTopology::TriangeList;
+			vehicle.worldMatrix = Matrix::CreateTranslation(Vector3{ 0.0f, 0.0f, 50.0f });
+
+			return vehicle;
+		}
+
+		struct FrameTimes
+		{
+			double milliseconds{};
+			uint64_t cacheMisses{};
+			bool hasCacheMisses{};
+		};
+
+		//Renders a warm up frame and then frameCount timed ones, prints their average time and cache misses behind label and returns those
+		//With a world matrix the mesh turns through a full rotation around it over the frames, so every run sees the same angles
+		//onFrameRendered runs after each timed frame, outside the measurement
+		FrameTimes TimeFrames(Renderer& renderer, Timer& timer, int frameCount, const std::string& label,
+			const Matrix* pWorldMatrix = nullptr, const std::function<void()>& onFrameRendered = {})
+		{
+			CacheMissCounter cacheMissCounter{};
+
+			//Warm up caches and the first frame allocations
+			if (pWorldMatrix)
+				renderer.SetMeshWorldMatrix(*pWorldMatrix);
+			renderer.Update(&timer);
+			renderer.Render();
+
+			double totalMilliseconds{};
+			uint64_t totalCacheMisses{};
+
+			for (int frame{}; frame < frameCount; ++frame)
+			{
+				if (pWorldMatrix)
+				{
+					const float angle{ 2.f * PI * frame / frameCount };
+					renderer.SetMeshWorldMatrix(Matrix::CreateRotationY(angle) * *pWorldMatrix);
+				}
+				renderer.Update(&timer);
+
+				cacheMissCounter.Start();
+				const auto start{ std::chrono::high_resolution_clock::now() };
+
+				renderer.Render();
+
+				const auto end{ std::chrono::high_resolution_clock::now() };
+				totalCacheMisses += cacheMissCounter.Stop();
+
+				totalMilliseconds += std::chrono::duration<double, std::milli>(end - start).count();
+
+				if (onFrameRendered)
+					onFrameRendered();
+			}
+
+			const FrameTimes frameTimes{ totalMilliseconds / frameCount, totalCacheMisses / frameCount, cacheMissCounter.IsValid() };
+
+			std::cout << std::left << std::setw(28) << label
+				<< std::right << std::fixed << std::setprecision(3) << std::setw(10) << frameTimes.milliseconds << " ms/frame";
+
+			if (frameTimes.hasCacheMisses)
+				std::cout << std::setw(14) << frameTimes.cacheMisses << " cache misses/frame";
+
+			std::cout << "\n";
+
+			return frameTimes;
+		}
+
+		//Printed once below a table whose frames ran without cache miss counters
+		void PrintCacheMissNote(const FrameTimes& frameTimes)
+		{
+			if (!frameTimes.hasCacheMisses)
+				std::cout << "(cache miss counters unavailable on this platform, profile with VTune or perf for those)\n";
+		}
+
+		FrameTimes RunScene(Renderer& renderer, Timer& timer, int frameCount, const char* sceneName)
+		{
+			const Renderer::TraversalOrder orders[]
+			{
+				Renderer::TraversalOrder::ColumnMajor,
+				Renderer::TraversalOrder::RowMajor,
+				Renderer::TraversalOrder::Block
+			};
+
+			const char* orderNames[]{ "Column major", "Row major", "Block 8x8" };
+
+			FrameTimes frameTimes{};
+
+			for (int orderIdx{}; orderIdx < 3; ++orderIdx)
+			{
+				renderer.SetTraversalOrder(orders[orderIdx]);
+				frameTimes = TimeFrames(renderer, timer, frameCount, std::string{ sceneName } + ", " + orderNames[orderIdx]);
+			}
+
+			return frameTimes;
+		}
+
+		float GetLargestDeviation(const std::vector<Vertex_Out>& exact, const std::vector<Vertex_Out>& approximated)
+		{
+			float largestDeviation{};
+
+			for (size_t i{}; i < exact.size(); ++i)
+			{
+				const float deviations[]
+				{
+					(exact[i].position - approximated[i].position).Magnitude(),
+					(exact[i].normal - approximated[i].normal).Magnitude(),
+					(exact[i].tangent - approximated[i].tangent).Magnitude(),
+					(exact[i].viewDirection - approximated[i].viewDirection).Magnitude()
+				};
+
+				for (const float deviation : deviations)
+				{
+					//Degenerate input vectors normalize to nan in every kernel
+					if (!std::isnan(deviation))
+						largestDeviation = std::max(largestDeviation, deviation);
+				}
+			}
+
+			return largestDeviation;
+		}
+	}
+
+	void Benchmark::RunTraversalBenchmark(Renderer& renderer, Timer& timer, int frameCount)
+	{
+		std::cout << "--- Traversal benchmark, per pixel rasterizer, single threaded, " << frameCount << " frames ---\n";
+
+		//Only the walk order may differ between runs
+		renderer.SetRotation(false);
+		renderer.SetMultithreading(false);
+		renderer.SetRasterizerMode(Renderer::RasterizerMode::PerPixel);
+
+		renderer.SetMesh(CreateFullScreenQuad());
+		RunScene(renderer, timer, frameCount, "Quad");
+
+		renderer.SetMesh(CreateVehicle());
+		PrintCacheMissNote(RunScene(renderer, timer, frameCount, "Vehicle"));
+	}
+
+	void Benchmark::RunVertexBenchmark(int iterationCount)
+	{
+		const Mesh vehicle{ CreateVehicle() };
+
+		if (vehicle.vertices.empty())
+		{
+			std::cout << "--- Vertex benchmark skipped, Resources/vehicle.obj could not be loaded ---\n";
+			return;
+		}
+
+		std::vector<Vertex> vertices{};
+		while (vertices.size() < 100000)
+		{
+			vertices.insert(vertices.end(), vehicle.vertices.begin(), vehicle.vertices.end());
+		}
+
+		std::cout << "--- Vertex benchmark, " << vertices.size() << " vertices, " << iterationCount << " transforms ---\n";
+
+		Camera camera{};
+		camera.Initialize(45.f, { .0f,.0f, 0.f }, 4 / 3.f);
+		camera.CalculateViewMatrix();
+		camera.CalculateProjectionMatrix();
+
+		const Matrix worldViewProjection{ vehicle.worldMatrix * camera.viewMatrix * camera.projectionMatrix };
+
+		std::vector<VertexTransformKernel> kernels{ &VertexKernels::TransformScalar };
+#if defined(DAE_X86)
+		kernels.push_back(&VertexKernels::TransformSSE);
+		if (CpuFeatures::SupportsAVX2())
+			kernels.push_back(&VertexKernels::TransformAVX2);
+#endif
+
+		std::vector<Vertex_Out> exactVertices(vertices.size());
+		VertexKernels::TransformScalar(worldViewProjection, vehicle.worldMatrix, vertices.data(), exactVertices.data(), static_cast<int>(vertices.size()));
+
+		std::vector<Vertex_Out> verticesOut(vertices.size());
+		double scalarMilliseconds{};
+
+		for (const VertexTransformKernel kernel : kernels)
+		{
+			const auto start{ std::chrono::high_resolution_clock::now() };
+
+			for (int iteration{}; iteration < iterationCount; ++iteration)
+			{
+				kernel(worldViewProjection, vehicle.worldMatrix, vertices.data(), verticesOut.data(), static_cast<int>(vertices.size()));
+			}
+
+			const auto end{ std::chrono::high_resolution_clock::now() };
+			const double milliseconds{ std::chrono::duration<double, std::milli>(end - start).count() / iterationCount };
+
+			if (kernel == &VertexKernels::TransformScalar)
+				scalarMilliseconds = milliseconds;
+
+			std::cout << std::left << std::setw(10) << VertexKernels::GetKernelName(kernel)
+				<< std::right << std::fixed << std::setprecision(3) << std::setw(10) << milliseconds << " ms/transform"
+				<< std::setw(8) << std::setprecision(1) << scalarMilliseconds / milliseconds << "x"
+				<< std::setw(14) << std::scientific << std::setprecision(2) << GetLargestDeviation(exactVertices, verticesOut) << " max deviation\n";
+			std::cout << std::defaultfloat;
+		}
+	}
+
+	void Benchmark::RunTextureLayoutBenchmark(Renderer& renderer, Timer& timer, int frameCount)
+	{
+		std::cout << "--- Texture layout benchmark, rotating vehicle, single threaded, " << frameCount << " frames ---\n";
+
+		//Rotation is driven per frame by TimeFrames
+		renderer.SetRotation(false);
+		renderer.SetMultithreading(false);
+		renderer.SetRasterizerMode(Renderer::RasterizerMode::Simd);
+
+		const Mesh vehicle{ CreateVehicle() };
+		renderer.SetMesh(vehicle);
+
+		const TextureFilter filters[]{ TextureFilter::Point, TextureFilter::Trilinear };
+		const char* filterNames[]{ "Point", "Trilinear" };
+
+		const TextureLayout layouts[]{ TextureLayout::Linear, TextureLayout::Tiled };
+		const char* layoutNames[]{ "Linear", "Tiled" };
+
+		FrameTimes frameTimes{};
+
+		for (int filterIdx{}; filterIdx < 2; ++filterIdx)
+		{
+			renderer.SetTextureFilter(filters[filterIdx]);
+
+			for (int layoutIdx{}; layoutIdx < 2; ++layoutIdx)
+			{
+				renderer.SetTextureLayout(layouts[layoutIdx]);
+				frameTimes = TimeFrames(renderer, timer, frameCount, std::string{ filterNames[filterIdx] } + ", " + layoutNames[layoutIdx], &vehicle.worldMatrix);
+			}
+		}
+
+		PrintCacheMissNote(frameTimes);
+
+		renderer.SetTextureLayout(TextureLayout::Linear);
+	}
+
+	bool Benchmark::RunFastMathBenchmark(Renderer& renderer, Timer& timer, int frameCount)
+	{
+		//Largest and mean difference of a color channel, out of 255, the fast path may introduce
+		const int maxChannelErrorThreshold{ 2 };
+		const double meanChannelErrorThreshold{ .01 };
+
+		std::cout << "--- Fast math benchmark, rotating vehicle, single threaded, " << frameCount << " frames ---\n";
+
+		renderer.SetRotation(false);
+		renderer.SetMultithreading(false);
+		renderer.SetRasterizerMode(Renderer::RasterizerMode::Simd);
+
+		const Mesh vehicle{ CreateVehicle() };
+		renderer.SetMesh(vehicle);
+
+		const int pixelCount{ renderer.GetWidth() * renderer.GetHeight() };
+		std::vector<uint32_t> fastColors(pixelCount);
+
+		int maxChannelError{};
+		uint64_t totalChannelError{};
+		uint64_t differingPixelCount{};
+
+		//Renders the exact image of the angle the fast one was just timed at and compares both
+		const auto compareWithExact = [&]()
+			{
+				std::copy_n(renderer.GetColorBuffer(), pixelCount, fastColors.begin());
+
+				renderer.SetFastMath(false);
+				renderer.Render();
+				renderer.SetFastMath(true);
+
+				const uint32_t* pExactColors{ renderer.GetColorBuffer() };
+
+				for (int pixelIdx{}; pixelIdx < pixelCount; ++pixelIdx)
+				{
+					if (pExactColors[pixelIdx] == fastColors[pixelIdx])
+						continue;
+
+					++differingPixelCount;
+
+					for (int shift{}; shift < 24; shift += 8)
+					{
+						const int exactChannel{ static_cast<int>((pExactColors[pixelIdx] >> shift) & 0xFF) };
+						const int fastChannel{ static_cast<int>((fastColors[pixelIdx] >> shift) & 0xFF) };
+						const int channelError{ std::abs(exactChannel - fastChannel) };
+
+						maxChannelError = std::max(maxChannelError, channelError);
+						totalChannelError += channelError;
+					}
+				}
+			};
+
+		renderer.SetFastMath(false);
+		TimeFrames(renderer, timer, frameCount, "Exact", &vehicle.worldMatrix);
+
+		renderer.SetFastMath(true);
+		PrintCacheMissNote(TimeFrames(renderer, timer, frameCount, "Fast math", &vehicle.worldMatrix, compareWithExact));
+
+		renderer.SetFastMath(false);
+
+		const double meanChannelError{ static_cast<double>(totalChannelError) / (3.0 * pixelCount * frameCount) };
+		const bool hasPassed{ maxChannelError <= maxChannelErrorThreshold && meanChannelError <= meanChannelErrorThreshold };
+
+		std::cout << "Differing pixels: " << std::setprecision(4) << 100.0 * differingPixelCount / (static_cast<double>(pixelCount) * frameCount) << "%"
+			<< ", max channel error: " << maxChannelError << " (limit " << maxChannelErrorThreshold << ")"
+			<< ", mean channel error: " << meanChannelError << " (limit " << meanChannelErrorThreshold << ")\n"
+			<< "Fast math image error " << (hasPassed ? "within limits" : "EXCEEDS LIMITS") << "\n";
+
+		return hasPassed;
+	}
+
+	bool Benchmark::RunVertexCacheBenchmark(Renderer& renderer, Timer& timer, int frameCount)
+	{
+		const Mesh vehicle{ CreateVehicle() };
+
+		if (vehicle.vertices.empty())
+		{
+			std::cout << "--- Vertex cache benchmark skipped, Resources/vehicle.obj could not be loaded ---\n";
+			return true;
+		}
+
+		std::cout << "--- Vertex cache benchmark, rotating vehicle, single threaded, " << frameCount << " frames ---\n";
+
+		Mesh optimizedVehicle{ vehicle };
+
+		const auto optimizeStart{ std::chrono::high_resolution_clock::now() };
+		Utils::OptimizeVertexCache(optimizedVehicle.vertices, optimizedVehicle.indices);
+		const auto optimizeEnd{ std::chrono::high_resolution_clock::now() };
+
+		//Both have to draw the same triangles, each with its corners in the same winding
+		const auto getSortedTriangles = [](const Mesh& mesh)
+			{
+				std::vector<std::array<Vertex, 3>> triangles(mesh.indices.size() / 3);
+				for (size_t i{}; i < triangles.size(); ++i)
+				{
+					triangles[i] = { mesh.vertices[mesh.indices[3 * i]], mesh.vertices[mesh.indices[3 * i + 1]], mesh.vertices[mesh.indices[3 * i + 2]] };
+				}
+
+				std::sort(triangles.begin(), triangles.end(), [](const std::array<Vertex, 3>& a, const std::array<Vertex, 3>& b)
+					{
+						return std::memcmp(a.data(), b.data(), sizeof(a)) < 0;
+					});
+
+				return triangles;
+			};
+
+		const std::vector<std::array<Vertex, 3>> triangles{ getSortedTriangles(vehicle) };
+		const std::vector<std::array<Vertex, 3>> optimizedTriangles{ getSortedTriangles(optimizedVehicle) };
+
+		const bool isSameMesh{ optimizedVehicle.vertices.size() == vehicle.vertices.size()
+			&& std::equal(triangles.begin(), triangles.end(), optimizedTriangles.begin(), optimizedTriangles.end(),
+				[](const std::array<Vertex, 3>& a, const std::array<Vertex, 3>& b) { return std::memcmp(a.data(), b.data(), sizeof(a)) == 0; }) };
+
+		std::cout << "Optimized in " << std::fixed << std::setprecision(1)
+			<< std::chrono::duration<double, std::milli>(optimizeEnd - optimizeStart).count() << " ms, same triangles "
+			<< (isSameMesh ? "yes" : "NO") << "\n";
+
+		for (const int cacheSize : { 16, 32 })
+		{
+			std::cout << "ACMR FIFO " << std::setw(2) << cacheSize << std::setprecision(3)
+				<< std::setw(10) << Utils::CalculateACMR(vehicle.indices, vehicle.vertices.size(), cacheSize) << " file order"
+				<< std::setw(10) << Utils::CalculateACMR(optimizedVehicle.indices, optimizedVehicle.vertices.size(), cacheSize) << " optimized\n";
+		}
+
+		//Rotation is driven per frame by TimeFrames
+		renderer.SetRotation(false);
+		renderer.SetMultithreading(false);
+		renderer.SetRasterizerMode(Renderer::RasterizerMode::Simd);
+
+		renderer.SetMesh(vehicle);
+		TimeFrames(renderer, timer, frameCount, "File order", &vehicle.worldMatrix);
+
+		renderer.SetMesh(optimizedVehicle);
+		PrintCacheMissNote(TimeFrames(renderer, timer, frameCount, "Optimized", &vehicle.worldMatrix));
+
+		std::cout << std::defaultfloat;
+
+		return isSameMesh;
+	}
+
+	bool Benchmark::RunObjLoaderBenchmark(int copyCount)
+	{
+		std::ifstream vehicleFile("Resources/vehicle.obj", std::ios::binary);
+		if (!vehicleFile)
+		{
+			std::cout << "--- OBJ loader benchmark skipped, Resources/vehicle.obj could not be loaded ---\n";
+			return true;
+		}
+
+		const std::string vehicleText{ std::istreambuf_iterator<char>{ vehicleFile }, std::istreambuf_iterator<char>{} };
+
+		//Faces of every copy point at the vertices of the first one, so the large file stays a valid obj
+		const std::filesystem::path largePath{ std::filesystem::temp_directory_path() / "rasterizer_benchmark.obj" };
+		{
+			std::ofstream largeFile(largePath, std::ios::binary);
+			for (int copy{}; copy < copyCount; ++copy)
+			{
+				largeFile << vehicleText << '\n';
+			}
+		}
+
+		const double megabytes{ static_cast<double>(std::filesystem::file_size(largePath)) / (1024.0 * 1024.0) };
+
+		std::cout << "--- OBJ loader benchmark, vehicle repeated " << copyCount << " times, "
+			<< std::fixed << std::setprecision(1) << megabytes << " MB ---\n";
+
+		const auto timeParse = [&largePath](const auto& parse, Mesh& mesh)
+			{
+				const auto start{ std::chrono::high_resolution_clock::now() };
+				parse(largePath.string(), mesh.vertices, mesh.indices);
+				const auto end{ std::chrono::high_resolution_clock::now() };
+
+				return std::chrono::duration<double, std::milli>(end - start).count();
+			};
+
+		ThreadPool threadPool{};
+
+		Mesh streamMesh{};
+		Mesh fastMesh{};
+		Mesh threadedMesh{};
+		const double streamMilliseconds{ timeParse([](const std::string& filename, std::vector<Vertex>& vertices, std::vector<uint32_t>& indices)
+			{
+				return Utils::ParseOBJStream(filename, vertices, indices);
+			}, streamMesh) };
+		const double fastMilliseconds{ timeParse([](const std::string& filename, std::vector<Vertex>& vertices, std::vector<uint32_t>& indices)
+			{
+				return Utils::ParseOBJ(filename, vertices, indices);
+			}, fastMesh) };
+		const double threadedMilliseconds{ timeParse([&threadPool](const std::string& filename, std::vector<Vertex>& vertices, std::vector<uint32_t>& indices)
+			{
+				return Utils::ParseOBJ(filename, vertices, indices, true, &threadPool);
+			}, threadedMesh) };
+
+		std::filesystem::remove(largePath);
+
+		//What later starts see, the parsed mesh written once and mapped back in
+		const std::filesystem::path meshPath{ std::filesystem::temp_directory_path() / "rasterizer_benchmark.mesh" };
+		fastMesh.primitiveTopology = PrimitiveTopology::TriangeList;
+		fastMesh.bounds = Utils::CalculateBounds(fastMesh.vertices);
+		MeshFile::Write(meshPath.string(), fastMesh);
+
+		const auto mapStart{ std::chrono::high_resolution_clock::now() };
+		const MeshFile* pMeshFile{ MeshFile::Open(meshPath.string()) };
+		const auto mapEnd{ std::chrono::high_resolution_clock::now() };
+		const double mapMilliseconds{ std::chrono::duration<double, std::milli>(mapEnd - mapStart).count() };
+
+		const bool isMeshFileIdentical{ pMeshFile
+			&& std::equal(fastMesh.indices.begin(), fastMesh.indices.end(), pMeshFile->GetIndices().begin(), pMeshFile->GetIndices().end())
+			&& pMeshFile->GetVertices().size() == fastMesh.vertices.size()
+			&& std::memcmp(pMeshFile->GetVertices().data(), fastMesh.vertices.data(), fastMesh.vertices.size() * sizeof(Vertex)) == 0 };
+
+		delete pMeshFile;
+		std::filesystem::remove(meshPath);
+
+		//ParseOBJ shares vertices between corners, so the meshes are compared corner by corner
+		//Tangents are left out, a shared vertex averages those of more triangles
+		const auto isSameCorner = [](const Vertex& a, const Vertex& b)
+			{
+				return std::memcmp(&a.position, &b.position, sizeof(Vector3)) == 0
+					&& std::memcmp(&a.uv, &b.uv, sizeof(Vector2)) == 0
+					&& std::memcmp(&a.normal, &b.normal, sizeof(Vector3)) == 0;
+			};
+
+		bool isIdentical{ streamMesh.indices.size() == fastMesh.indices.size() };
+		for (size_t i{}; isIdentical && i < fastMesh.indices.size(); ++i)
+		{
+			isIdentical = isSameCorner(streamMesh.vertices[streamMesh.indices[i]], fastMesh.vertices[fastMesh.indices[i]]);
+		}
+
+		//Splitting the work up may not change a single bit, tangents included
+		const bool isThreadedIdentical{ threadedMesh.indices == fastMesh.indices
+			&& threadedMesh.vertices.size() == fastMesh.vertices.size()
+			&& std::memcmp(threadedMesh.vertices.data(), fastMesh.vertices.data(), fastMesh.vertices.size() * sizeof(Vertex)) == 0 };
+
+		std::cout << std::fixed
+			<< std::left << std::setw(14) << "iostream" << std::right << std::setprecision(1) << std::setw(10) << streamMilliseconds << " ms"
+			<< std::setw(10) << megabytes * 1000.0 / streamMilliseconds << " MB/s\n"
+			<< std::left << std::setw(14) << "from_chars" << std::right << std::setw(10) << fastMilliseconds << " ms"
+			<< std::setw(10) << megabytes * 1000.0 / fastMilliseconds << " MB/s"
+			<< std::setw(8) << streamMilliseconds / fastMilliseconds << "x\n"
+			<< std::left << std::setw(14) << "threaded" << std::right << std::setw(10) << threadedMilliseconds << " ms"
+			<< std::setw(10) << megabytes * 1000.0 / threadedMilliseconds << " MB/s"
+			<< std::setw(8) << streamMilliseconds / threadedMilliseconds << "x, "
+			<< threadPool.GetThreadCount() << " threads\n"
+			<< std::left << std::setw(14) << "mesh file" << std::right << std::setw(10) << std::setprecision(3) << mapMilliseconds << std::setprecision(1) << " ms to map\n"
+			<< fastMesh.indices.size() / 3 << " triangles, " << fastMesh.vertices.size() << " vertices, "
+			<< streamMesh.vertices.size() << " without sharing, corners "
+			<< (isIdentical ? "identical" : "DIFFER") << ", threaded mesh "
+			<< (isThreadedIdentical ? "identical" : "DIFFERS") << ", mesh file "
+			<< (isMeshFileIdentical ? "identical" : "DIFFERS") << "\n";
+		std::cout << std::defaultfloat;
+
+		return isIdentical && isThreadedIdentical && isMeshFileIdentical;
+	}
+}
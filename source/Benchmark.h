@@ -0,0 +1,35 @@
+#pragma once
+
+namespace dae
+{
+	class Renderer;
+	class Timer;
+
+	namespace Benchmark
+	{
+		//Renders a full screen quad and the vehicle mesh with every traversal order of the per pixel rasterizer
+		//and prints the frame time and, where the os exposes them, the cache misses per frame
+		void RunTraversalBenchmark(Renderer& renderer, Timer& timer, int frameCount = 100);
+
+		//Transforms the vehicle, repeated until it has over 100k vertices, with every vertex kernel the cpu supports
+		//and prints the time per transform together with the largest deviation from the exact scalar kernel
+		void RunVertexBenchmark(int iterationCount = 100);
+
+		//Renders the vehicle rotating through a full turn with linear and tiled texture layouts, for point and trilinear filtering
+		//and prints the frame time and, where the os exposes them, the cache misses per frame
+		void RunTextureLayoutBenchmark(Renderer& renderer, Timer& timer, int frameCount = 100);
+
+		//Renders the vehicle rotating through a full turn with exact and with fast math shading and prints both frame times
+		//together with the error of the fast images, returns false when that error exceeds the accepted thresholds
+		bool RunFastMathBenchmark(Renderer& renderer, Timer& timer, int frameCount = 100);
+
+		//Prints the average cache miss ratio of the vehicle's triangles in file order and after OptimizeVertexCache, then renders
+		//the vehicle rotating through a full turn in both orders, returns false when the optimized mesh lost or changed a triangle
+		bool RunVertexCacheBenchmark(Renderer& renderer, Timer& timer, int frameCount = 100);
+
+		//Loads the vehicle, repeated into one large obj, with the iostream, the from_chars and the threaded from_chars parser and prints each in MB/s
+		//together with the time to map the same mesh back in from a mesh file
+		//Returns false when the two parsers don't produce the same triangle corners or the threaded or mapped mesh isn't identical to the single threaded one
+		bool RunObjLoaderBenchmark(int copyCount = 20);
+	}
+}
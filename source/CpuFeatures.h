@@ -0,0 +1,46 @@
+#pragma once
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define DAE_X86
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#endif
+
+//MSVC allows AVX2 intrinsics anywhere, gcc and clang need the functions using them marked
+#if defined(__GNUC__) || defined(__clang__)
+#define DAE_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define DAE_TARGET_AVX2
+#endif
+
+namespace dae
+{
+	namespace CpuFeatures
+	{
+		inline bool SupportsAVX2()
+		{
+#if !defined(DAE_X86)
+			return false;
+#elif defined(_MSC_VER)
+			int info[4]{};
+			__cpuid(info, 0);
+			if (info[0] < 7)
+				return false;
+
+			//The os has to save the ymm registers too, not just the cpu supporting them
+			__cpuid(info, 1);
+			const bool hasOSXSave{ (info[2] & (1 << 27)) != 0 };
+			const bool hasAVX{ (info[2] & (1 << 28)) != 0 };
+			if (!hasOSXSave || !hasAVX || (_xgetbv(0) & 0x6) != 0x6)
+				return false;
+
+			__cpuidex(info, 7, 0);
+			return (info[1] & (1 << 5)) != 0;
+#else
+			return __builtin_cpu_supports("avx2");
+#endif
+		}
+	}
+}
@@ -1,6 +1,7 @@
 #pragma once
 #include "Math.h"
 #include "vector"
+#include <span>
 
 namespace dae
 {
@@ -28,6 +29,8 @@ namespace dae
 	{
 		Vector4 position{};
 		Vector2 uv{};
+		Vector2 uvDdx{}; //change of uv per pixel in screen x
+		Vector2 uvDdy{}; //change of uv per pixel in screen y
 		Vector3 normal{};
 		Vector3 tangent{};
 		Vector3 viewDirection{};
@@ -69,29 +72,108 @@ namespace dae
 		}
 	};
 
+	//Screen space rectangle, min inclusive and max exclusive
+	struct Tile
+	{
+		int minX{};
+		int minY{};
+
+		int maxX{};
+		int maxY{};
+	};
+
+	//Screen positions are snapped to fixed point before rasterization, so every edge test is exact
+	//28.4 as long as the screen allows it, larger screens give up fractional bits, see Renderer::Initialize
+	constexpr int MaxSubpixelBits{ 4 };
+
+	//Widest span in pixels between vertices and samples for which the edge functions still fit in 32 bits
+	constexpr int GetMaxFixedPointExtent(int subpixelBits)
+	{
+		return (1 << (15 - subpixelBits)) - 1;
+	}
+
+	//Edge equation Cross(end - start, sample - start) in fixed point, evaluated at the centre of a start pixel
+	//together with the constant it changes by when moving one pixel in x or y
+	struct EdgeFunction
+	{
+		EdgeFunction(const Int2& start, const Int2& end, int px, int py, int subpixelBits)
+		{
+			const int edgeX{ end.x - start.x };
+			const int edgeY{ end.y - start.y };
+
+			const int subpixelScale{ 1 << subpixelBits };
+			const int sampleX{ px * subpixelScale + subpixelScale / 2 };
+			const int sampleY{ py * subpixelScale + subpixelScale / 2 };
+
+			value = edgeX * (sampleY - start.y) - edgeY * (sampleX - start.x);
+			stepX = -edgeY * subpixelScale;
+			stepY = edgeX * subpixelScale;
+
+			//Top-left rule: a sample exactly on an edge belongs to the triangle only if that edge is a top or left one,
+			//so triangles sharing the edge never both cover it nor leave it uncovered
+			const bool isTopLeft{ edgeY < 0 || (edgeY == 0 && edgeX > 0) };
+			threshold = isTopLeft ? -1 : 0;
+		}
+
+		bool Covers(int edgeValue) const
+		{
+			return edgeValue > threshold;
+		}
+
+		int value{};
+		int stepX{};
+		int stepY{};
+		int threshold{};
+	};
+
 	enum class PrimitiveTopology
 	{
 		TriangeList,
 		TriangleStrip
 	};
 
+	//Object space bounding volumes of a mesh, a mesh outside the view frustum is skipped as a whole with them
+	struct MeshBounds
+	{
+		Vector3 min{};
+		Vector3 max{};
+
+		Vector3 center{};
+		float radius{};
+	};
+
 	struct Mesh
 	{
 		std::vector<Vertex> vertices{};
 		std::vector<uint32_t> indices{};
 		PrimitiveTopology primitiveTopology{ PrimitiveTopology::TriangleStrip };
+		MeshBounds bounds{};
 
 		std::vector<Vertex_Out> vertices_out{};
 		Matrix worldMatrix{};
+
+		//Arrays of a mapped MeshFile, used in place while the vectors above are empty
+		std::span<const Vertex> mappedVertices{};
+		std::span<const uint32_t> mappedIndices{};
+
+		std::span<const Vertex> GetVertices() const { return vertices.empty() ? mappedVertices : std::span<const Vertex>{ vertices }; };
+		std::span<const uint32_t> GetIndices() const { return indices.empty() ? mappedIndices : std::span<const uint32_t>{ indices }; };
 	};
 
 	struct Triangle
 	{
-		Triangle() {
-			ndc.resize(3); screen.resize(3);
-		};
-		std::vector<Vertex_Out> ndc;
-		std::vector<Vector2> screen;
+		Vertex_Out ndc[3];
+		Vector2 screen[3];
 		BoundingBox boundingBox;
+
+		//Screen positions in the renderer's subpixel fixed point and 1 / twice the area they span, what the rasterizers work with
+		Int2 fixedScreen[3];
+		float inverseFixedArea{};
+
+		//uv / w and 1 / w are linear in screen space, so their change per pixel is the same over the whole triangle
+		Vector2 uvOverWDdx{};
+		Vector2 uvOverWDdy{};
+		float inverseWDdx{};
+		float inverseWDdy{};
 	};
 }
\ No newline at end of file
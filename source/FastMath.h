@@ -0,0 +1,95 @@
+#pragma once
+#include <algorithm>
+#include <bit>
+#include <cfloat>
+#include <cmath>
+#include <cstdint>
+#include "CpuFeatures.h"
+#include "Vector3.h"
+
+namespace dae
+{
+	//Approximations of the shading math, cheaper than the exact versions at a bounded error
+	//Renderer::ToggleFastMath switches shading between these and the exact path
+	namespace FastMath
+	{
+		//1 / x, hardware estimate refined by one Newton-Raphson step, relative error below 1e-6
+		inline float Reciprocal(float x)
+		{
+#if defined(DAE_X86)
+			const float estimate{ _mm_cvtss_f32(_mm_rcp_ss(_mm_set_ss(x))) };
+			return estimate * (2.f - x * estimate);
+#else
+			return 1.f / x;
+#endif
+		}
+
+		//1 / sqrt(x), hardware estimate refined by one Newton-Raphson step, relative error below 1e-6
+		inline float ReciprocalSqrt(float x)
+		{
+#if defined(DAE_X86)
+			const float estimate{ _mm_cvtss_f32(_mm_rsqrt_ss(_mm_set_ss(x))) };
+			return estimate * (1.5f - .5f * x * estimate * estimate);
+#else
+			return 1.f / std::sqrt(x);
+#endif
+		}
+
+		inline Vector3 Normalized(const Vector3& v)
+		{
+			return v * ReciprocalSqrt(Vector3::Dot(v, v));
+		}
+
+		inline void Normalize(Vector3& v)
+		{
+			v *= ReciprocalSqrt(Vector3::Dot(v, v));
+		}
+
+		//log2 of a normal positive float, absolute error below 1.5e-5
+		inline float Log2(float x)
+		{
+			const uint32_t bits{ std::bit_cast<uint32_t>(x) };
+			const float exponent{ static_cast<float>(static_cast<int>(bits >> 23) - 127) };
+
+			//Mantissa - 1, in [0, 1)
+			const float m{ std::bit_cast<float>((bits & 0x007FFFFFu) | 0x3F800000u) - 1.f };
+
+			//Minimax fit of log2(1 + m)
+			const float polynomial{ m * (1.441965570f + m * (-0.7096623429f + m * (0.4175942668f + m * (-0.1962677433f + m * 0.04638454695f)))) };
+			return exponent + polynomial;
+		}
+
+		//2^x, relative error below 3e-6, flushes to 0 where the result would be denormal
+		inline float Exp2(float x)
+		{
+			if (x < -126.f)
+				return 0.f;
+
+			x = std::min(x, 127.99f);
+
+			int whole{ static_cast<int>(x) };
+			if (static_cast<float>(whole) > x)
+				--whole;
+
+			const float f{ x - static_cast<float>(whole) };
+			const float scale{ std::bit_cast<float>(static_cast<uint32_t>(whole + 127) << 23) };
+
+			//Minimax fit of 2^f on [0, 1)
+			const float polynomial{ 1.000002593f + f * (0.6930038297f + f * (0.2414428056f + f * (0.05201135641f + f * 0.01353423029f))) };
+			return scale * polynomial;
+		}
+
+		//base^exponent for base >= 0 and exponent >= 0 as exp2(exponent * log2(base))
+		//Relative error stays below 1.2e-5 * exponent + 3e-6, Pow(x, 0) is 1 like powf
+		inline float Pow(float base, float exponent)
+		{
+			if (exponent == 0.f)
+				return 1.f;
+
+			if (base < FLT_MIN)
+				return 0.f;
+
+			return Exp2(exponent * Log2(base));
+		}
+	}
+}
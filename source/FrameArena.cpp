@@ -0,0 +1,78 @@
+#include "FrameArena.h"
+
+#include <cstdint>
+
+using namespace dae;
+
+FrameArena::FrameArena(size_t capacity) :
+	m_pBlock{ new char[capacity] },
+	m_Capacity{ capacity }
+{
+}
+
+FrameArena::~FrameArena()
+{
+	for (char* pOverflow : m_Overflows)
+	{
+		delete[] pOverflow;
+	}
+
+	delete[] m_pBlock;
+}
+
+void FrameArena::Reset()
+{
+	if (HasOverflowed())
+	{
+		for (char* pOverflow : m_Overflows)
+		{
+			delete[] pOverflow;
+		}
+		m_Overflows.clear();
+
+		//Grow with some headroom so a frame that is slightly bigger doesn't overflow again
+		const size_t neededCapacity{ m_Offset + m_OverflowSize };
+
+		delete[] m_pBlock;
+		m_Capacity = neededCapacity + neededCapacity / 2;
+		m_pBlock = new char[m_Capacity];
+
+		m_OverflowSize = 0;
+	}
+
+	m_Offset = 0;
+}
+
+void FrameArena::Reserve(size_t capacity)
+{
+	Reset();
+
+	if (capacity <= m_Capacity)
+		return;
+
+	delete[] m_pBlock;
+	m_Capacity = capacity;
+	m_pBlock = new char[m_Capacity];
+}
+
+void* FrameArena::AllocateBytes(size_t size, size_t alignment)
+{
+	const uintptr_t blockStart{ reinterpret_cast<uintptr_t>(m_pBlock) };
+	const uintptr_t alignedStart{ (blockStart + m_Offset + alignment - 1) & ~(uintptr_t(alignment) - 1) };
+	const size_t alignedOffset{ alignedStart - blockStart };
+
+	if (alignedOffset + size <= m_Capacity)
+	{
+		m_Offset = alignedOffset + size;
+		return m_pBlock + alignedOffset;
+	}
+
+	//Doesn't fit, fall back to the heap for the rest of this frame
+	const size_t overflowSize{ size + alignment };
+	char* pOverflow{ new char[overflowSize] };
+	m_Overflows.push_back(pOverflow);
+	m_OverflowSize += overflowSize;
+
+	const uintptr_t overflowStart{ reinterpret_cast<uintptr_t>(pOverflow) };
+	return reinterpret_cast<void*>((overflowStart + alignment - 1) & ~(uintptr_t(alignment) - 1));
+}
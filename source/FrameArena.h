@@ -0,0 +1,50 @@
+#pragma once
+
+//Standard includes
+#include <cstddef>
+#include <type_traits>
+#include <vector>
+
+namespace dae
+{
+	//Bump allocator for memory that only lives for a single frame
+	//Everything is released at once by Reset, when a frame didn't fit the block grows so the next frames don't hit the heap
+	class FrameArena final
+	{
+	public:
+		explicit FrameArena(size_t capacity);
+		~FrameArena();
+
+		FrameArena(const FrameArena&) = delete;
+		FrameArena(FrameArena&&) noexcept = delete;
+		FrameArena& operator=(const FrameArena&) = delete;
+		FrameArena& operator=(FrameArena&&) noexcept = delete;
+
+		//Returns uninitialized storage for count objects, valid until the next Reset
+		template<typename T>
+		T* Allocate(size_t count)
+		{
+			static_assert(std::is_trivially_destructible_v<T>, "The arena never runs destructors");
+			return static_cast<T*>(AllocateBytes(count * sizeof(T), alignof(T)));
+		}
+
+		void Reset();
+
+		//Resets and grows the block to at least capacity, for when the size of the coming frames is known up front
+		void Reserve(size_t capacity);
+
+		size_t GetCapacity() const { return m_Capacity; };
+		bool HasOverflowed() const { return !m_Overflows.empty(); };
+
+	private:
+		char* m_pBlock{ nullptr };
+		size_t m_Capacity{};
+		size_t m_Offset{};
+
+		//Allocations that didn't fit the block anymore, only freed on the next Reset
+		std::vector<char*> m_Overflows{};
+		size_t m_OverflowSize{};
+
+		void* AllocateBytes(size_t size, size_t alignment);
+	};
+}
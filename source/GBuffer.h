@@ -0,0 +1,60 @@
+#pragma once
+#include <cstdint>
+#include "Math.h"
+
+namespace dae
+{
+	//Surface data the rasterizer writes per visible pixel in deferred mode, depth lives in the depth buffer
+	struct GBufferTexel
+	{
+		Vector2 uv{};
+		Vector2 uvDdx{}; //texture level of detail
+		Vector2 uvDdy{};
+		uint32_t normal{}; //octahedral, 2 x 16 bit snorm
+		Vector3 tangent{}; //not unit length after interpolation, so it can't go through the octahedral packing
+		Vector3 viewDirection{};
+	};
+
+	namespace GBuffer
+	{
+		//Octahedral encoding: project the unit vector on the octahedron |x| + |y| + |z| = 1,
+		//fold the lower half over the diagonals and store x and y as 16 bit signed normalized values
+		inline uint32_t PackUnitVector(const Vector3& v)
+		{
+			const float sum{ std::abs(v.x) + std::abs(v.y) + std::abs(v.z) };
+			if (sum <= 0.f)
+				return 0;
+
+			float x{ v.x / sum };
+			float y{ v.y / sum };
+
+			if (v.z < 0.f)
+			{
+				const float foldedX{ (1.f - std::abs(y)) * (x >= 0.f ? 1.f : -1.f) };
+				const float foldedY{ (1.f - std::abs(x)) * (y >= 0.f ? 1.f : -1.f) };
+				x = foldedX;
+				y = foldedY;
+			}
+
+			const int16_t packedX{ static_cast<int16_t>(std::lround(Clamp(x, -1.f, 1.f) * 32767.f)) };
+			const int16_t packedY{ static_cast<int16_t>(std::lround(Clamp(y, -1.f, 1.f) * 32767.f)) };
+
+			return static_cast<uint16_t>(packedX) | (static_cast<uint32_t>(static_cast<uint16_t>(packedY)) << 16);
+		}
+
+		inline Vector3 UnpackUnitVector(uint32_t packed)
+		{
+			const float x{ static_cast<int16_t>(packed & 0xFFFF) / 32767.f };
+			const float y{ static_cast<int16_t>(packed >> 16) / 32767.f };
+
+			Vector3 v{ x, y, 1.f - std::abs(x) - std::abs(y) };
+
+			//Unfold the lower half
+			const float t{ std::max(-v.z, 0.f) };
+			v.x += v.x >= 0.f ? -t : t;
+			v.y += v.y >= 0.f ? -t : t;
+
+			return v.Normalized();
+		}
+	}
+}
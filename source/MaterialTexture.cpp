@@ -0,0 +1,217 @@
+#include "MaterialTexture.h"
+#include "TexelFormat.h"
+#include "Vector2.h"
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+namespace dae
+{
+	namespace
+	{
+		uint32_t GetTexelOr(const Texture* pTexture, uint32_t defaultTexel, int level, int x, int y)
+		{
+			return pTexture ? pTexture->GetTexel(level, x, y) : defaultTexel;
+		}
+	}
+
+	MaterialTexture* MaterialTexture::Create(const Texture& diffuse, const Texture* pGloss, const Texture* pSpecular, const Texture* pNormal)
+	{
+		const Texture* pTextures[]{ pGloss, pSpecular, pNormal };
+		for (const Texture* pTexture : pTextures)
+		{
+			if (pTexture && (pTexture->GetWidth() != diffuse.GetWidth() || pTexture->GetHeight() != diffuse.GetHeight()))
+				return nullptr;
+		}
+
+		MaterialTexture* pMaterial{ new MaterialTexture{} };
+
+		//Same size means the same chain, so every level interleaves texel for texel
+		for (int levelIdx{}; levelIdx < diffuse.GetMipLevelCount(); ++levelIdx)
+		{
+			MipLevel level{ diffuse.GetWidth(levelIdx), diffuse.GetHeight(levelIdx) };
+			AllocateTexels(level, static_cast<size_t>(level.width) * level.height);
+
+			for (int y{}; y < level.height; ++y)
+			{
+				for (int x{}; x < level.width; ++x)
+				{
+					MaterialTexel& texel{ level.pTexels[x + static_cast<size_t>(y) * level.width] };
+
+					//Gloss only ever uses its red channel
+					texel.diffuseGloss = (diffuse.GetTexel(levelIdx, x, y) & 0x00FFFFFF) | ((GetTexelOr(pGloss, TexelFormat::FlatGloss, levelIdx, x, y) & 0xFF) << 24);
+					texel.specular = GetTexelOr(pSpecular, TexelFormat::FlatSpecular, levelIdx, x, y);
+					texel.normal = GetTexelOr(pNormal, TexelFormat::FlatNormal, levelIdx, x, y);
+				}
+			}
+
+			pMaterial->m_MipLevels.push_back(std::move(level));
+		}
+
+		return pMaterial;
+	}
+
+	MaterialTexture* MaterialTexture::LoadFromFiles(const std::string& diffusePath, const std::string& glossPath, const std::string& specularPath, const std::string& normalPath)
+	{
+		const Texture* pDiffuse{ Texture::LoadFromFile(diffusePath) };
+		const Texture* pGloss{ Texture::LoadFromFile(glossPath) };
+		const Texture* pSpecular{ Texture::LoadFromFile(specularPath) };
+		const Texture* pNormal{ Texture::LoadFromFile(normalPath) };
+
+		//LoadFromFile already reported which map is missing, only the diffuse map decides the size and can't be left out
+		MaterialTexture* pMaterial{ nullptr };
+		if (!pDiffuse)
+		{
+			std::cout << "Material of " << diffusePath << " has no diffuse map, can't pack it\n";
+		}
+		else
+		{
+			pMaterial = Create(*pDiffuse, pGloss, pSpecular, pNormal);
+			if (!pMaterial)
+				std::cout << "Material maps of " << diffusePath << " differ in size, can't pack them\n";
+		}
+
+		delete pDiffuse;
+		delete pGloss;
+		delete pSpecular;
+		delete pNormal;
+
+		return pMaterial;
+	}
+
+	MaterialSample MaterialTexture::Sample(const Vector2& uv, const Vector2& uvDdx, const Vector2& uvDdy, TextureFilter filter) const
+	{
+		const int baseWidth{ m_MipLevels[0].width };
+		const int baseHeight{ m_MipLevels[0].height };
+		const int levelCount{ static_cast<int>(m_MipLevels.size()) };
+
+		switch (filter)
+		{
+		case TextureFilter::Bilinear:
+		{
+			const int level{ static_cast<int>(std::lround(Texture::CalculateMipLevel(uvDdx, uvDdy, baseWidth, baseHeight, levelCount))) };
+			return SampleBilinear(m_MipLevels[level], uv);
+		}
+		case TextureFilter::Trilinear:
+		{
+			const float level{ Texture::CalculateMipLevel(uvDdx, uvDdy, baseWidth, baseHeight, levelCount) };
+			const int finerLevel{ static_cast<int>(level) };
+			const int coarserLevel{ std::min(finerLevel + 1, levelCount - 1) };
+
+			const MaterialSample finerSample{ SampleBilinear(m_MipLevels[finerLevel], uv) };
+			if (coarserLevel == finerLevel)
+				return finerSample;
+
+			return MaterialSample::Lerp(finerSample, SampleBilinear(m_MipLevels[coarserLevel], uv), level - finerLevel);
+		}
+		case TextureFilter::Point:
+		default:
+			return SamplePoint(uv);
+		}
+	}
+
+	void MaterialTexture::SetLayout(TextureLayout layout)
+	{
+		if (layout == m_Layout)
+			return;
+
+		for (MipLevel& level : m_MipLevels)
+		{
+			MipLevel rearranged{ level.width, level.height };
+
+			if (layout == TextureLayout::Tiled)
+			{
+				//Tiles sticking out past the right or bottom edge are only partly filled
+				rearranged.tileCountX = (level.width + TileSize - 1) / TileSize;
+				const int tileCountY{ (level.height + TileSize - 1) / TileSize };
+				AllocateTexels(rearranged, static_cast<size_t>(rearranged.tileCountX) * tileCountY * TileSize * TileSize);
+			}
+			else
+			{
+				AllocateTexels(rearranged, static_cast<size_t>(level.width) * level.height);
+			}
+
+			for (int y{}; y < level.height; ++y)
+			{
+				for (int x{}; x < level.width; ++x)
+				{
+					rearranged.pTexels[GetTexelIndex(rearranged, layout, x, y)] = level.pTexels[GetTexelIndex(level, m_Layout, x, y)];
+				}
+			}
+
+			level = std::move(rearranged);
+		}
+
+		m_Layout = layout;
+	}
+
+	void MaterialTexture::AllocateTexels(MipLevel& level, size_t texelCount)
+	{
+		//Vector storage is only 16 byte aligned, the spare texels let pTexels start on a cache line, and with it every tile
+		level.storage.resize(texelCount + CacheLineTexelCount - 1);
+
+		const uintptr_t address{ reinterpret_cast<uintptr_t>(level.storage.data()) };
+		const uintptr_t alignedAddress{ (address + 63) & ~uintptr_t(63) };
+
+		level.pTexels = level.storage.data() + (alignedAddress - address) / sizeof(MaterialTexel);
+	}
+
+	size_t MaterialTexture::GetTexelIndex(const MipLevel& level, TextureLayout layout, int x, int y)
+	{
+		if (layout == TextureLayout::Linear)
+			return x + static_cast<size_t>(y) * level.width;
+
+		const unsigned int tileX{ static_cast<unsigned int>(x) / TileSize };
+		const unsigned int tileY{ static_cast<unsigned int>(y) / TileSize };
+		const unsigned int texelInTile{ (static_cast<unsigned int>(y) % TileSize) * TileSize + static_cast<unsigned int>(x) % TileSize };
+
+		return (tileX + static_cast<size_t>(tileY) * level.tileCountX) * TileSize * TileSize + texelInTile;
+	}
+
+	MaterialSample MaterialTexture::Fetch(const MipLevel& level, int x, int y) const
+	{
+		const MaterialTexel& texel{ level.pTexels[GetTexelIndex(level, m_Layout, x, y)] };
+
+		return
+		{
+			TexelFormat::UnpackRGB(texel.diffuseGloss),
+			TexelFormat::UnpackA(texel.diffuseGloss),
+			TexelFormat::UnpackRGB(texel.specular),
+			TexelFormat::UnpackRGB(texel.normal)
+		};
+	}
+
+	MaterialSample MaterialTexture::SamplePoint(const Vector2& uv) const
+	{
+		const MipLevel& baseLevel{ m_MipLevels[0] };
+
+		//uv 1 would land one texel past the edge
+		const int x{ Clamp(static_cast<int>(uv.x * baseLevel.width), 0, baseLevel.width - 1) };
+		const int y{ Clamp(static_cast<int>(uv.y * baseLevel.height), 0, baseLevel.height - 1) };
+
+		return Fetch(baseLevel, x, y);
+	}
+
+	MaterialSample MaterialTexture::SampleBilinear(const MipLevel& level, const Vector2& uv) const
+	{
+		//Texel centers sit at half texel offsets, clamp to the edge outside of them
+		const float x{ uv.x * level.width - 0.5f };
+		const float y{ uv.y * level.height - 0.5f };
+
+		const float floorX{ std::floor(x) };
+		const float floorY{ std::floor(y) };
+
+		const float fractionX{ x - floorX };
+		const float fractionY{ y - floorY };
+
+		const int x0{ Clamp(static_cast<int>(floorX), 0, level.width - 1) };
+		const int y0{ Clamp(static_cast<int>(floorY), 0, level.height - 1) };
+		const int x1{ Clamp(static_cast<int>(floorX) + 1, 0, level.width - 1) };
+		const int y1{ Clamp(static_cast<int>(floorY) + 1, 0, level.height - 1) };
+
+		const MaterialSample top{ MaterialSample::Lerp(Fetch(level, x0, y0), Fetch(level, x1, y0), fractionX) };
+		const MaterialSample bottom{ MaterialSample::Lerp(Fetch(level, x0, y1), Fetch(level, x1, y1), fractionX) };
+
+		return MaterialSample::Lerp(top, bottom, fractionY);
+	}
+}
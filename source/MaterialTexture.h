@@ -0,0 +1,94 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "ColorRGB.h"
+#include "Texture.h"
+
+namespace dae
+{
+	struct Vector2;
+
+	//Everything the shading of a pixel reads from the material maps
+	struct MaterialSample
+	{
+		ColorRGB diffuse{};
+		float gloss{};
+		ColorRGB specular{};
+		ColorRGB normal{}; //still in [0, 1], not yet a tangent space vector
+
+		static MaterialSample Lerp(const MaterialSample& s1, const MaterialSample& s2, float factor)
+		{
+			return
+			{
+				ColorRGB::Lerp(s1.diffuse, s2.diffuse, factor),
+				Lerpf(s1.gloss, s2.gloss, factor),
+				ColorRGB::Lerp(s1.specular, s2.specular, factor),
+				ColorRGB::Lerp(s1.normal, s2.normal, factor)
+			};
+		}
+	};
+
+	//Diffuse, gloss, specular and normal map interleaved per texel, so shading a pixel reads one texel instead of four
+	//Sampling matches sampling the four textures separately exactly
+	class MaterialTexture
+	{
+	public:
+		~MaterialTexture() = default;
+
+		MaterialTexture(const MaterialTexture&) = delete;
+		MaterialTexture(MaterialTexture&&) noexcept = delete;
+		MaterialTexture& operator=(const MaterialTexture&) = delete;
+		MaterialTexture& operator=(MaterialTexture&&) noexcept = delete;
+
+		//Builds the packed texture, mip chain included, from the four textures, which all need the same size
+		//A missing gloss, specular or normal map is packed as no gloss, no specular and a flat normal
+		static MaterialTexture* Create(const Texture& diffuse, const Texture* pGloss, const Texture* pSpecular, const Texture* pNormal);
+
+		//Loads the four images and packs them, maps that fail to load fall back to the defaults of Create
+		//nullptr if the diffuse map fails to load or the sizes differ
+		static MaterialTexture* LoadFromFiles(const std::string& diffusePath, const std::string& glossPath, const std::string& specularPath, const std::string& normalPath);
+
+		//Same filtering and level selection as Texture::Sample
+		MaterialSample Sample(const Vector2& uv, const Vector2& uvDdx, const Vector2& uvDdy, TextureFilter filter) const;
+
+		//Rearranges the texels of every level, sampling gives the same result in both layouts
+		void SetLayout(TextureLayout layout);
+		TextureLayout GetLayout() const { return m_Layout; };
+
+	private:
+		MaterialTexture() = default;
+
+		//16 bytes so four texels share a cache line and none straddles two, every word is RGBA8 as in TexelFormat
+		struct alignas(16) MaterialTexel
+		{
+			uint32_t diffuseGloss{}; //diffuse in rgb, gloss in a
+			uint32_t specular{};
+			uint32_t normal{};
+			uint32_t padding{};
+		};
+
+		struct MipLevel
+		{
+			int width{};
+			int height{};
+			int tileCountX{}; //tiles per tile row, tiled layout only
+
+			std::vector<MaterialTexel> storage{};
+			MaterialTexel* pTexels{ nullptr }; //first cache line aligned texel of storage
+		};
+
+		static constexpr int TileSize{ 2 };
+		static constexpr size_t CacheLineTexelCount{ 64 / sizeof(MaterialTexel) };
+
+		static void AllocateTexels(MipLevel& level, size_t texelCount);
+		static size_t GetTexelIndex(const MipLevel& level, TextureLayout layout, int x, int y);
+
+		MaterialSample Fetch(const MipLevel& level, int x, int y) const;
+		MaterialSample SamplePoint(const Vector2& uv) const;
+		MaterialSample SampleBilinear(const MipLevel& level, const Vector2& uv) const;
+
+		std::vector<MipLevel> m_MipLevels{};
+		TextureLayout m_Layout{ TextureLayout::Linear };
+	};
+}
@@ -0,0 +1,268 @@
+#include "MeshFile.h"
+#include "Utils.h"
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <type_traits>
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace dae
+{
+	namespace
+	{
+		static_assert(std::is_trivially_copyable_v<Vertex> && std::is_trivially_copyable_v<MeshBounds>, "Mesh files store vertices and bounds byte for byte");
+
+		constexpr std::array<char, 4> Magic{ 'D', 'A', 'E', 'M' };
+
+		//Bump whenever the header or what LoadOBJ stores changes, files of other versions then get written again
+		//2: triangles and vertices in vertex cache order
+		//3: size and write time of the source file
+		constexpr uint32_t Version{ 3 };
+
+		struct MeshFileHeader
+		{
+			std::array<char, 4> magic{};
+			uint32_t version{};
+			uint32_t vertexSize{};
+			uint32_t vertexCount{};
+			uint32_t indexCount{};
+			uint32_t primitiveTopology{};
+			MeshBounds bounds{};
+
+			//The file the mesh was made from when it was written, 0 when there was none
+			uint64_t sourceSize{};
+			int64_t sourceWriteTime{};
+		};
+
+		//Vertices start on the first cache line after the header, the indices follow right behind them
+		constexpr size_t VertexOffset{ (sizeof(MeshFileHeader) + 63) / 64 * 64 };
+
+		size_t GetIndexOffset(const MeshFileHeader& header)
+		{
+			return VertexOffset + size_t{ header.vertexCount } * sizeof(Vertex);
+		}
+
+		size_t GetFileSize(const MeshFileHeader& header)
+		{
+			return GetIndexOffset(header) + size_t{ header.indexCount } * sizeof(uint32_t);
+		}
+
+		//Size and write time of a file, both 0 when it doesn't exist
+		void GetSourceStamp(const std::string& path, uint64_t& size, int64_t& writeTime)
+		{
+			std::error_code sizeError{};
+			std::error_code timeError{};
+			const uintmax_t fileSize{ std::filesystem::file_size(path, sizeError) };
+			const std::filesystem::file_time_type fileTime{ std::filesystem::last_write_time(path, timeError) };
+
+			size = sizeError ? 0 : static_cast<uint64_t>(fileSize);
+			writeTime = timeError ? 0 : static_cast<int64_t>(fileTime.time_since_epoch().count());
+		}
+
+		//Maps the whole file read only, returns nullptr when it is missing or empty
+		const std::byte* MapFile(const std::string& path, size_t& size)
+		{
+#if defined(_WIN32)
+			const HANDLE file{ CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr) };
+			if (file == INVALID_HANDLE_VALUE)
+				return nullptr;
+
+			LARGE_INTEGER fileSize{};
+			void* pView{ nullptr };
+
+			if (GetFileSizeEx(file, &fileSize) && fileSize.QuadPart > 0)
+			{
+				//The view keeps the mapping alive, both handles can be closed right away
+				const HANDLE mapping{ CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr) };
+				if (mapping)
+				{
+					pView = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+					CloseHandle(mapping);
+				}
+			}
+			CloseHandle(file);
+
+			size = static_cast<size_t>(fileSize.QuadPart);
+			return static_cast<const std::byte*>(pView);
+#else
+			const int fileDescriptor{ open(path.c_str(), O_RDONLY) };
+			if (fileDescriptor < 0)
+				return nullptr;
+
+			struct stat status{};
+			void* pView{ MAP_FAILED };
+
+			//The mapping stays valid after the descriptor is closed
+			if (fstat(fileDescriptor, &status) == 0 && status.st_size > 0)
+				pView = mmap(nullptr, static_cast<size_t>(status.st_size), PROT_READ, MAP_PRIVATE, fileDescriptor, 0);
+			close(fileDescriptor);
+
+			if (pView == MAP_FAILED)
+				return nullptr;
+
+			size = static_cast<size_t>(status.st_size);
+			return static_cast<const std::byte*>(pView);
+#endif
+		}
+
+		void UnmapFile(const std::byte* pData, size_t size)
+		{
+#if defined(_WIN32)
+			(void)size;
+			UnmapViewOfFile(pData);
+#else
+			munmap(const_cast<std::byte*>(pData), size);
+#endif
+		}
+	}
+
+	MeshFile::~MeshFile()
+	{
+		if (m_pData)
+			UnmapFile(m_pData, m_Size);
+	}
+
+	MeshFile* MeshFile::Open(const std::string& path)
+	{
+		size_t size{};
+		const std::byte* pData{ MapFile(path, size) };
+		if (!pData)
+			return nullptr;
+
+		//Owns the mapping from here on, deleting it unmaps the file again
+		MeshFile* pMeshFile{ new MeshFile{} };
+		pMeshFile->m_pData = pData;
+		pMeshFile->m_Size = size;
+
+		//Mappings start on a page boundary, so the header and the arrays behind it are aligned
+		const MeshFileHeader* pHeader{ reinterpret_cast<const MeshFileHeader*>(pData) };
+
+		const bool isValid
+		{
+			size >= VertexOffset
+			&& pHeader->magic == Magic
+			&& pHeader->version == Version
+			&& pHeader->vertexSize == sizeof(Vertex)
+			&& pHeader->primitiveTopology <= static_cast<uint32_t>(PrimitiveTopology::TriangleStrip)
+			&& size >= GetFileSize(*pHeader)
+		};
+
+		if (!isValid)
+		{
+			delete pMeshFile;
+			return nullptr;
+		}
+
+		pMeshFile->m_Vertices = { reinterpret_cast<const Vertex*>(pData + VertexOffset), pHeader->vertexCount };
+		pMeshFile->m_Indices = { reinterpret_cast<const uint32_t*>(pData + GetIndexOffset(*pHeader)), pHeader->indexCount };
+
+		//Indices are fetched from without bounds checks, a corrupt one would read past the vertices
+		const uint32_t vertexCount{ pHeader->vertexCount };
+		if (std::any_of(pMeshFile->m_Indices.begin(), pMeshFile->m_Indices.end(), [vertexCount](uint32_t index) { return index >= vertexCount; }))
+		{
+			delete pMeshFile;
+			return nullptr;
+		}
+		pMeshFile->m_PrimitiveTopology = static_cast<PrimitiveTopology>(pHeader->primitiveTopology);
+		pMeshFile->m_Bounds = pHeader->bounds;
+		pMeshFile->m_SourceSize = pHeader->sourceSize;
+		pMeshFile->m_SourceWriteTime = pHeader->sourceWriteTime;
+
+		return pMeshFile;
+	}
+
+	MeshFile* MeshFile::LoadOBJ(const std::string& objPath, Mesh& mesh, ThreadPool* pThreadPool)
+	{
+		const std::string meshPath{ std::filesystem::path{ objPath }.replace_extension(".mesh").string() };
+
+		//The mesh file is stale as soon as the obj's size or write time differs from when it was written, in either direction,
+		//so an older obj copied or restored over it gets parsed again too. Without the obj the mesh file is all there is
+		uint64_t objSize{};
+		int64_t objWriteTime{};
+		GetSourceStamp(objPath, objSize, objWriteTime);
+		const bool hasOBJ{ objSize != 0 || objWriteTime != 0 };
+
+		MeshFile* pMeshFile{ Open(meshPath) };
+		if (pMeshFile && hasOBJ && (pMeshFile->m_SourceSize != objSize || pMeshFile->m_SourceWriteTime != objWriteTime))
+		{
+			delete pMeshFile;
+			pMeshFile = nullptr;
+		}
+
+		if (!pMeshFile)
+		{
+			mesh.vertices.clear();
+			mesh.indices.clear();
+			if (!Utils::ParseOBJ(objPath, mesh.vertices, mesh.indices, true, pThreadPool))
+				return nullptr;
+
+			//Done once here instead of on every start, the mesh file keeps the optimized order
+			Utils::OptimizeVertexCache(mesh.vertices, mesh.indices);
+
+			mesh.primitiveTopology = PrimitiveTopology::TriangeList;
+			mesh.bounds = Utils::CalculateBounds(mesh.vertices);
+
+			//Without a mesh file the parsed mesh is used as it is, the next start tries writing it again
+			if (!Write(meshPath, mesh, objPath))
+				return nullptr;
+
+			pMeshFile = Open(meshPath);
+			if (!pMeshFile)
+				return nullptr;
+		}
+
+		//Rendered straight from the mapping, a parsed copy isn't needed anymore
+		mesh.vertices = {};
+		mesh.indices = {};
+		mesh.mappedVertices = pMeshFile->GetVertices();
+		mesh.mappedIndices = pMeshFile->GetIndices();
+		mesh.primitiveTopology = pMeshFile->GetPrimitiveTopology();
+		mesh.bounds = pMeshFile->GetBounds();
+
+		return pMeshFile;
+	}
+
+	bool MeshFile::Write(const std::string& path, const Mesh& mesh, const std::string& sourcePath)
+	{
+		const std::span<const Vertex> vertices{ mesh.GetVertices() };
+		const std::span<const uint32_t> indices{ mesh.GetIndices() };
+
+		MeshFileHeader header{};
+		header.magic = Magic;
+		header.version = Version;
+		header.vertexSize = sizeof(Vertex);
+		header.vertexCount = static_cast<uint32_t>(vertices.size());
+		header.indexCount = static_cast<uint32_t>(indices.size());
+		header.primitiveTopology = static_cast<uint32_t>(mesh.primitiveTopology);
+		header.bounds = mesh.bounds;
+
+		if (!sourcePath.empty())
+			GetSourceStamp(sourcePath, header.sourceSize, header.sourceWriteTime);
+
+		std::ofstream file(path, std::ios::binary | std::ios::trunc);
+		if (!file)
+			return false;
+
+		const std::array<char, VertexOffset> padding{};
+		file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+		file.write(padding.data(), VertexOffset - sizeof(header));
+		file.write(reinterpret_cast<const char*>(vertices.data()), static_cast<std::streamsize>(vertices.size_bytes()));
+		file.write(reinterpret_cast<const char*>(indices.data()), static_cast<std::streamsize>(indices.size_bytes()));
+
+		//A write cut short leaves a file shorter than its header promises, which Open rejects
+		return static_cast<bool>(file);
+	}
+}
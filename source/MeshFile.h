@@ -0,0 +1,57 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string>
+#include "DataTypes.h"
+
+namespace dae
+{
+	class ThreadPool;
+
+	//Binary mesh cache, a versioned header with the topology and bounds followed by the final vertices and indices
+	//Opening maps the file into memory and hands out its arrays in place, nothing gets parsed or copied
+	class MeshFile final
+	{
+	public:
+		~MeshFile();
+
+		MeshFile(const MeshFile&) = delete;
+		MeshFile(MeshFile&&) noexcept = delete;
+		MeshFile& operator=(const MeshFile&) = delete;
+		MeshFile& operator=(MeshFile&&) noexcept = delete;
+
+		//Returns nullptr when the file is missing, was written by another version, holds fewer bytes than its header promises
+		//or has an index past its vertices
+		static MeshFile* Open(const std::string& path);
+
+		//Loads the obj into mesh through the .mesh file next to it, when there is none yet or the obj's size or write time changed
+		//the obj gets parsed, optimized for the vertex cache and written to that file first
+		//Returns the mapped file mesh renders from, it has to outlive mesh. When the mesh file can't be written nullptr is returned
+		//and mesh keeps the parsed obj in its vectors, mesh only stays empty when the obj couldn't be parsed either
+		static MeshFile* LoadOBJ(const std::string& objPath, Mesh& mesh, ThreadPool* pThreadPool = nullptr);
+
+		//Vertices and indices are stored as they are in memory, so a file only opens on a build with the same Vertex layout
+		//The size and write time of sourcePath, when given, are stored along so LoadOBJ can tell when that file changed
+		static bool Write(const std::string& path, const Mesh& mesh, const std::string& sourcePath = {});
+
+		std::span<const Vertex> GetVertices() const { return m_Vertices; };
+		std::span<const uint32_t> GetIndices() const { return m_Indices; };
+		PrimitiveTopology GetPrimitiveTopology() const { return m_PrimitiveTopology; };
+		const MeshBounds& GetBounds() const { return m_Bounds; };
+
+	private:
+		MeshFile() = default;
+
+		const std::byte* m_pData{ nullptr };
+		size_t m_Size{};
+
+		std::span<const Vertex> m_Vertices{};
+		std::span<const uint32_t> m_Indices{};
+		PrimitiveTopology m_PrimitiveTopology{ PrimitiveTopology::TriangeList };
+		MeshBounds m_Bounds{};
+
+		uint64_t m_SourceSize{};
+		int64_t m_SourceWriteTime{};
+	};
+}
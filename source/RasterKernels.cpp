@@ -0,0 +1,271 @@
+#include "RasterKernels.h"
+#include "CpuFeatures.h"
+
+#include <cassert>
+
+namespace dae
+{
+	uint32_t RasterKernels::CoverageDepthScalar(const RowKernelInput& input, int count, float* pDepthRow, uint32_t& coveredMask)
+	{
+		assert(count <= MaxPixelsPerCall);
+
+		int32_t edge01{ input.edge01 };
+		int32_t edge12{ input.edge12 };
+		int32_t edge20{ input.edge20 };
+
+		uint32_t passMask{};
+		coveredMask = 0;
+
+		for (int i{}; i < count; ++i)
+		{
+			if (edge01 > input.threshold01 && edge12 > input.threshold12 && edge20 > input.threshold20)
+			{
+				coveredMask |= 1u << i;
+
+				const float interpolatedZDepth
+				{
+					1.0f /
+						(static_cast<float>(edge12) * input.inverseTriangleArea * input.inverseZ0 +
+						static_cast<float>(edge20) * input.inverseTriangleArea * input.inverseZ1 +
+						static_cast<float>(edge01) * input.inverseTriangleArea * input.inverseZ2)
+				};
+
+				if (interpolatedZDepth >= 0.0f && interpolatedZDepth <= 1.0f && interpolatedZDepth <= pDepthRow[i])
+				{
+					pDepthRow[i] = interpolatedZDepth;
+					passMask |= 1u << i;
+				}
+			}
+
+			edge01 += input.stepX01;
+			edge12 += input.stepX12;
+			edge20 += input.stepX20;
+		}
+
+		return passMask;
+	}
+
+#if defined(DAE_X86)
+	uint32_t RasterKernels::CoverageDepthSSE(const RowKernelInput& input, int count, float* pDepthRow, uint32_t& coveredMask)
+	{
+		assert(count <= MaxPixelsPerCall);
+
+		const __m128 zero{ _mm_setzero_ps() };
+		const __m128 one{ _mm_set1_ps(1.0f) };
+		const __m128i laneIndices{ _mm_setr_epi32(0, 1, 2, 3) };
+
+		//SSE2 has no 32 bit multiply, the per lane offsets are done in scalar
+		const auto laneEdges = [](int32_t edge, int32_t step)
+			{
+				return _mm_setr_epi32(edge, edge + step, edge + 2 * step, edge + 3 * step);
+			};
+
+		__m128i edge01{ laneEdges(input.edge01, input.stepX01) };
+		__m128i edge12{ laneEdges(input.edge12, input.stepX12) };
+		__m128i edge20{ laneEdges(input.edge20, input.stepX20) };
+
+		const __m128i threshold01{ _mm_set1_epi32(input.threshold01) };
+		const __m128i threshold12{ _mm_set1_epi32(input.threshold12) };
+		const __m128i threshold20{ _mm_set1_epi32(input.threshold20) };
+
+		const __m128i groupStep01{ _mm_set1_epi32(4 * input.stepX01) };
+		const __m128i groupStep12{ _mm_set1_epi32(4 * input.stepX12) };
+		const __m128i groupStep20{ _mm_set1_epi32(4 * input.stepX20) };
+
+		const __m128 inverseArea{ _mm_set1_ps(input.inverseTriangleArea) };
+		const __m128 inverseZ0{ _mm_set1_ps(input.inverseZ0) };
+		const __m128 inverseZ1{ _mm_set1_ps(input.inverseZ1) };
+		const __m128 inverseZ2{ _mm_set1_ps(input.inverseZ2) };
+
+		uint32_t passMask{};
+		coveredMask = 0;
+
+		for (int i{}; i < count; i += 4)
+		{
+			const int remaining{ count - i };
+			const __m128i laneValid{ _mm_cmpgt_epi32(_mm_set1_epi32(remaining), laneIndices) };
+
+			const __m128 covered
+			{
+				_mm_castsi128_ps(_mm_and_si128(_mm_and_si128(_mm_cmpgt_epi32(edge01, threshold01), _mm_cmpgt_epi32(edge12, threshold12)),
+					_mm_and_si128(_mm_cmpgt_epi32(edge20, threshold20), laneValid)))
+			};
+
+			const int coveredBits{ _mm_movemask_ps(covered) };
+			if (coveredBits)
+			{
+				coveredMask |= static_cast<uint32_t>(coveredBits) << i;
+
+				const __m128 weightV0{ _mm_mul_ps(_mm_cvtepi32_ps(edge12), inverseArea) };
+				const __m128 weightV1{ _mm_mul_ps(_mm_cvtepi32_ps(edge20), inverseArea) };
+				const __m128 weightV2{ _mm_mul_ps(_mm_cvtepi32_ps(edge01), inverseArea) };
+
+				const __m128 interpolatedZDepth
+				{
+					_mm_div_ps(one, _mm_add_ps(_mm_add_ps(_mm_mul_ps(weightV0, inverseZ0), _mm_mul_ps(weightV1, inverseZ1)), _mm_mul_ps(weightV2, inverseZ2)))
+				};
+
+				//No masked loads in SSE, the tail of the row goes through a small copy so we never read past the buffer
+				alignas(16) float tail[4]{};
+				float* pDepth{ pDepthRow + i };
+				if (remaining < 4)
+				{
+					for (int lane{}; lane < remaining; ++lane)
+						tail[lane] = pDepth[lane];
+					pDepth = tail;
+				}
+
+				const __m128 depth{ _mm_loadu_ps(pDepth) };
+
+				const __m128 pass
+				{
+					_mm_and_ps(covered,
+						_mm_and_ps(_mm_and_ps(_mm_cmpge_ps(interpolatedZDepth, zero), _mm_cmple_ps(interpolatedZDepth, one)),
+							_mm_cmple_ps(interpolatedZDepth, depth)))
+				};
+
+				const int passBits{ _mm_movemask_ps(pass) };
+				if (passBits)
+				{
+					//Masked store through a blend, failing lanes write back what was already there
+					_mm_storeu_ps(pDepth, _mm_or_ps(_mm_and_ps(pass, interpolatedZDepth), _mm_andnot_ps(pass, depth)));
+
+					if (remaining < 4)
+					{
+						for (int lane{}; lane < remaining; ++lane)
+							pDepthRow[i + lane] = tail[lane];
+					}
+
+					passMask |= static_cast<uint32_t>(passBits) << i;
+				}
+			}
+
+			edge01 = _mm_add_epi32(edge01, groupStep01);
+			edge12 = _mm_add_epi32(edge12, groupStep12);
+			edge20 = _mm_add_epi32(edge20, groupStep20);
+		}
+
+		return passMask;
+	}
+
+	DAE_TARGET_AVX2 uint32_t RasterKernels::CoverageDepthAVX2(const RowKernelInput& input, int count, float* pDepthRow, uint32_t& coveredMask)
+	{
+		assert(count <= MaxPixelsPerCall);
+
+		const __m256 zero{ _mm256_setzero_ps() };
+		const __m256 one{ _mm256_set1_ps(1.0f) };
+		const __m256i laneIndices{ _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7) };
+
+		const __m256i stepX01{ _mm256_set1_epi32(input.stepX01) };
+		const __m256i stepX12{ _mm256_set1_epi32(input.stepX12) };
+		const __m256i stepX20{ _mm256_set1_epi32(input.stepX20) };
+
+		__m256i edge01{ _mm256_add_epi32(_mm256_set1_epi32(input.edge01), _mm256_mullo_epi32(laneIndices, stepX01)) };
+		__m256i edge12{ _mm256_add_epi32(_mm256_set1_epi32(input.edge12), _mm256_mullo_epi32(laneIndices, stepX12)) };
+		__m256i edge20{ _mm256_add_epi32(_mm256_set1_epi32(input.edge20), _mm256_mullo_epi32(laneIndices, stepX20)) };
+
+		const __m256i threshold01{ _mm256_set1_epi32(input.threshold01) };
+		const __m256i threshold12{ _mm256_set1_epi32(input.threshold12) };
+		const __m256i threshold20{ _mm256_set1_epi32(input.threshold20) };
+
+		const __m256i groupStep01{ _mm256_slli_epi32(stepX01, 3) };
+		const __m256i groupStep12{ _mm256_slli_epi32(stepX12, 3) };
+		const __m256i groupStep20{ _mm256_slli_epi32(stepX20, 3) };
+
+		const __m256 inverseArea{ _mm256_set1_ps(input.inverseTriangleArea) };
+		const __m256 inverseZ0{ _mm256_set1_ps(input.inverseZ0) };
+		const __m256 inverseZ1{ _mm256_set1_ps(input.inverseZ1) };
+		const __m256 inverseZ2{ _mm256_set1_ps(input.inverseZ2) };
+
+		uint32_t passMask{};
+		coveredMask = 0;
+
+		for (int i{}; i < count; i += 8)
+		{
+			//Lanes past the end of the row are never loaded nor stored
+			const __m256i laneValid{ _mm256_cmpgt_epi32(_mm256_set1_epi32(count - i), laneIndices) };
+
+			const __m256 covered
+			{
+				_mm256_castsi256_ps(_mm256_and_si256(_mm256_and_si256(_mm256_cmpgt_epi32(edge01, threshold01), _mm256_cmpgt_epi32(edge12, threshold12)),
+					_mm256_and_si256(_mm256_cmpgt_epi32(edge20, threshold20), laneValid)))
+			};
+
+			const int coveredBits{ _mm256_movemask_ps(covered) };
+			if (coveredBits)
+			{
+				coveredMask |= static_cast<uint32_t>(coveredBits) << i;
+
+				const __m256 weightV0{ _mm256_mul_ps(_mm256_cvtepi32_ps(edge12), inverseArea) };
+				const __m256 weightV1{ _mm256_mul_ps(_mm256_cvtepi32_ps(edge20), inverseArea) };
+				const __m256 weightV2{ _mm256_mul_ps(_mm256_cvtepi32_ps(edge01), inverseArea) };
+
+				const __m256 interpolatedZDepth
+				{
+					_mm256_div_ps(one, _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(weightV0, inverseZ0), _mm256_mul_ps(weightV1, inverseZ1)), _mm256_mul_ps(weightV2, inverseZ2)))
+				};
+
+				const __m256 depth{ _mm256_maskload_ps(pDepthRow + i, laneValid) };
+
+				const __m256 pass
+				{
+					_mm256_and_ps(covered,
+						_mm256_and_ps(_mm256_and_ps(_mm256_cmp_ps(interpolatedZDepth, zero, _CMP_GE_OQ), _mm256_cmp_ps(interpolatedZDepth, one, _CMP_LE_OQ)),
+							_mm256_cmp_ps(interpolatedZDepth, depth, _CMP_LE_OQ)))
+				};
+
+				const int passBits{ _mm256_movemask_ps(pass) };
+				if (passBits)
+				{
+					_mm256_maskstore_ps(pDepthRow + i, _mm256_castps_si256(pass), interpolatedZDepth);
+
+					passMask |= static_cast<uint32_t>(passBits) << i;
+				}
+			}
+
+			edge01 = _mm256_add_epi32(edge01, groupStep01);
+			edge12 = _mm256_add_epi32(edge12, groupStep12);
+			edge20 = _mm256_add_epi32(edge20, groupStep20);
+		}
+
+		return passMask;
+	}
+#else
+	uint32_t RasterKernels::CoverageDepthSSE(const RowKernelInput& input, int count, float* pDepthRow, uint32_t& coveredMask)
+	{
+		return CoverageDepthScalar(input, count, pDepthRow, coveredMask);
+	}
+
+	uint32_t RasterKernels::CoverageDepthAVX2(const RowKernelInput& input, int count, float* pDepthRow, uint32_t& coveredMask)
+	{
+		return CoverageDepthScalar(input, count, pDepthRow, coveredMask);
+	}
+#endif
+
+	CoverageDepthKernel RasterKernels::SelectCoverageDepthKernel()
+	{
+#if defined(DAE_X86)
+		if (CpuFeatures::SupportsAVX2())
+			return &CoverageDepthAVX2;
+
+		//SSE2 is part of every x64 cpu
+		return &CoverageDepthSSE;
+#else
+		return &CoverageDepthScalar;
+#endif
+	}
+
+	const char* RasterKernels::GetKernelName(CoverageDepthKernel kernel)
+	{
+#if defined(DAE_X86)
+		if (kernel == &CoverageDepthAVX2)
+			return "AVX2";
+		if (kernel == &CoverageDepthSSE)
+			return "SSE";
+#endif
+		if (kernel == &CoverageDepthScalar)
+			return "Scalar";
+
+		return "Unknown";
+	}
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+//Standard includes
+#include <cstdint>
+
+namespace dae
+{
+	//Everything a row kernel needs to test coverage and depth of consecutive pixels
+	//Edge values are the fixed point ones of the first pixel centre, the steps are what they change by per pixel in x
+	struct RowKernelInput
+	{
+		int32_t edge01{};
+		int32_t edge12{};
+		int32_t edge20{};
+
+		int32_t stepX01{};
+		int32_t stepX12{};
+		int32_t stepX20{};
+
+		//A pixel is covered when every edge value is above its threshold, see EdgeFunction
+		int32_t threshold01{};
+		int32_t threshold12{};
+		int32_t threshold20{};
+
+		float inverseTriangleArea{};
+
+		//1 / z of every vertex, so the kernels only multiply
+		float inverseZ0{};
+		float inverseZ1{};
+		float inverseZ2{};
+	};
+
+	//Tests coverage and depth of count (<= 32) consecutive pixels and stores the depth of every pixel that passes
+	//Returns a bitmask of the pixels that passed, coveredMask receives the pixels inside the triangle regardless of depth
+	using CoverageDepthKernel = uint32_t(*)(const RowKernelInput& input, int count, float* pDepthRow, uint32_t& coveredMask);
+
+	namespace RasterKernels
+	{
+		constexpr int MaxPixelsPerCall{ 32 };
+
+		uint32_t CoverageDepthScalar(const RowKernelInput& input, int count, float* pDepthRow, uint32_t& coveredMask);
+		uint32_t CoverageDepthSSE(const RowKernelInput& input, int count, float* pDepthRow, uint32_t& coveredMask);
+		uint32_t CoverageDepthAVX2(const RowKernelInput& input, int count, float* pDepthRow, uint32_t& coveredMask);
+
+		//Picks the widest kernel the running cpu supports, falls back to the scalar one
+		CoverageDepthKernel SelectCoverageDepthKernel();
+
+		const char* GetKernelName(CoverageDepthKernel kernel);
+	}
+}
@@ -4,18 +4,92 @@
 
 //Project includes
 #include "Renderer.h"
+#include "AllocationCounter.h"
+#include "FastMath.h"
+#include "FrameArena.h"
 #include "Math.h"
+#include "GBuffer.h"
+#include "MaterialTexture.h"
 #include "Matrix.h"
+#include "MeshFile.h"
+#include "RasterKernels.h"
+#include "TexelFormat.h"
 #include "Texture.h"
+#include "ThreadPool.h"
 #include "Utils.h"
+#include "VertexKernels.h"
 
 #include <algorithm>
+#include <array>
+#include <bit>
+#include <functional>
 #include <iostream>
+#include <span>
+#include <utility>
 
 using namespace dae;
 
 #define UseTriangleStruct
 
+namespace
+{
+	//Planes a vertex lies on the outside of, one bit each
+	enum ClipCode : uint16_t
+	{
+		ClipNear = 1 << 0,
+		ClipFar = 1 << 1,
+		ClipLeft = 1 << 2,
+		ClipRight = 1 << 3,
+		ClipBottom = 1 << 4,
+		ClipTop = 1 << 5,
+		ClipGuardLeft = 1 << 6,
+		ClipGuardRight = 1 << 7,
+		ClipGuardBottom = 1 << 8,
+		ClipGuardTop = 1 << 9
+	};
+
+	//A triangle with all vertices outside one of these can't be visible
+	constexpr uint16_t TrivialRejectMask{ ClipNear | ClipFar | ClipLeft | ClipRight | ClipBottom | ClipTop };
+
+	//Only crossing these needs actual clipping, the screen edges are left to the rasterizer within the guard band
+	constexpr uint16_t ClipMask{ ClipNear | ClipGuardLeft | ClipGuardRight | ClipGuardBottom | ClipGuardTop };
+
+	//A triangle plus one vertex per plane in ClipMask
+	constexpr int MaxClipVertexCount{ 3 + 5 };
+
+	//position in clip space, before the perspective divide
+	uint16_t CalculateClipCode(const Vector4& position, float nearPlane, const Vector2& guardBand)
+	{
+		uint16_t clipCode{};
+
+		if (position.w < nearPlane) clipCode |= ClipNear;
+		if (position.z > position.w) clipCode |= ClipFar;
+		if (position.x < -position.w) clipCode |= ClipLeft;
+		if (position.x > position.w) clipCode |= ClipRight;
+		if (position.y < -position.w) clipCode |= ClipBottom;
+		if (position.y > position.w) clipCode |= ClipTop;
+		if (position.x < -guardBand.x * position.w) clipCode |= ClipGuardLeft;
+		if (position.x > guardBand.x * position.w) clipCode |= ClipGuardRight;
+		if (position.y < -guardBand.y * position.w) clipCode |= ClipGuardBottom;
+		if (position.y > guardBand.y * position.w) clipCode |= ClipGuardTop;
+
+		return clipCode;
+	}
+
+	Vertex_Out LerpVertex(const Vertex_Out& v0, const Vertex_Out& v1, float factor)
+	{
+		return
+		{
+			v0.position + (v1.position - v0.position) * factor,
+			ColorRGB::Lerp(v0.color, v1.color, factor),
+			v0.uv + (v1.uv - v0.uv) * factor,
+			v0.normal + (v1.normal - v0.normal) * factor,
+			v0.tangent + (v1.tangent - v0.tangent) * factor,
+			v0.viewDirection + (v1.viewDirection - v0.viewDirection) * factor
+		};
+	}
+}
+
 Renderer::Renderer(SDL_Window* pWindow) :
 	m_pWindow(pWindow)
 {
@@ -28,6 +102,34 @@ Renderer::Renderer(SDL_Window* pWindow) :
 	m_pBackBufferPixels = (uint32_t*)m_pBackBuffer->pixels;
 
 	m_pDepthBufferPixels = new float[m_Width * m_Height];
+	m_OwnsDepthBuffer = true;
+
+	Initialize();
+}
+
+Renderer::Renderer(uint32_t* pColorBuffer, float* pDepthBuffer, int width, int height)
+{
+	m_Width = width;
+	m_Height = height;
+
+	//Software surface over the caller's pixels, surfaces don't need the video subsystem
+	//Same 0x00RRGGBB layout SDL_CreateRGBSurface picks for the window back buffer
+	m_pBackBuffer = SDL_CreateRGBSurfaceFrom(pColorBuffer, m_Width, m_Height, 32, m_Width * static_cast<int>(sizeof(uint32_t)),
+		0x00FF0000, 0x0000FF00, 0x000000FF, 0);
+	m_pBackBufferPixels = pColorBuffer;
+
+	m_pDepthBufferPixels = pDepthBuffer;
+
+	Initialize();
+}
+
+void dae::Renderer::Initialize()
+{
+	m_pGBuffer = new GBufferTexel[m_Width * m_Height];
+
+	m_HiZWidth = (m_Width + m_HiZBlockSize - 1) / m_HiZBlockSize;
+	m_HiZHeight = (m_Height + m_HiZBlockSize - 1) / m_HiZBlockSize;
+	m_pHiZBuffer = new float[m_HiZWidth * m_HiZHeight];
 
 	//calculate aspect ratio
 	m_AspectRatio = static_cast<float>(m_Width) / m_Height;
@@ -35,57 +137,158 @@ Renderer::Renderer(SDL_Window* pWindow) :
 	//Initialize Camera
 	m_Camera.Initialize(45.f, { .0f,.0f, 0.f }, m_AspectRatio);
 
+	//Initialize tiles and the workers that render them
+	assert(m_TileSize % m_HiZBlockSize == 0 && "Hi-Z blocks may not straddle tiles");
+	m_TileCountX = (m_Width + m_TileSize - 1) / m_TileSize;
+	m_TileCountY = (m_Height + m_TileSize - 1) / m_TileSize;
+	m_TileCount = m_TileCountX * m_TileCountY;
+
+	//Every fractional bit given up doubles the extent the 32 bit edge functions reach, pixel centres need at least one
+	const int screenExtent{ std::max(m_Width, m_Height) };
+	m_SubpixelBits = MaxSubpixelBits;
+	while (m_SubpixelBits > 1 && GetMaxFixedPointExtent(m_SubpixelBits) - screenExtent < 4)
+	{
+		--m_SubpixelBits;
+	}
+
+	//A pixel of slack for vertices the clipper puts right on the guard band
+	m_GuardBandSize = (GetMaxFixedPointExtent(m_SubpixelBits) - screenExtent) / 2 - 1;
+	m_IsInitialized = m_GuardBandSize > 0;
+	if (!m_IsInitialized)
+		std::cout << "A " << m_Width << "x" << m_Height << " screen is larger than the " << GetMaxFixedPointExtent(1) - 4 << " pixels the rasterizer supports, nothing gets rendered\n";
+	m_GuardBand = { 1.f + 2.f * m_GuardBandSize / m_Width, 1.f + 2.f * m_GuardBandSize / m_Height };
+
+	m_pThreadPool = new ThreadPool{};
+
+	//Sized to the mesh by InitializeMesh, the arena grows itself if a frame needs more
+	m_pFrameArena = new FrameArena{ 64 * 1024 };
+
+	//Pick the widest coverage and depth kernel this cpu can run
+	m_CoverageDepthKernel = RasterKernels::SelectCoverageDepthKernel();
+	m_VertexTransformKernel = VertexKernels::SelectTransformKernel();
+
 	//temporary texture
 	m_pDiffuseTexture = Texture::LoadFromFile("Resources/vehicle_diffuse.png");
 	m_pGlossTexture = Texture::LoadFromFile("Resources/vehicle_gloss.png");
 	m_pSpecularTexture = Texture::LoadFromFile("Resources/vehicle_specular.png");
 	m_pNormalMap = Texture::LoadFromFile("Resources/vehicle_normal.png");
 
+	//Missing gloss, specular and normal maps are shaded flat, without a diffuse map there is nothing to shade
+	if (m_pDiffuseTexture)
+	{
+		m_pMaterialTexture = MaterialTexture::Create(*m_pDiffuseTexture, m_pGlossTexture, m_pSpecularTexture, m_pNormalMap);
+	}
+	else
+	{
+		std::cout << "The renderer needs a diffuse texture, nothing gets rendered\n";
+		m_IsInitialized = false;
+	}
+	m_UsePackedMaterial = m_pMaterialTexture != nullptr;
+
 	InitializeMesh();
 }
 
 void dae::Renderer::InitializeMesh()
 {
-#ifdef UseTriangleStruct
-
-	m_Mesh =
+	//Two quads in a strip, small enough to follow single triangles through the rasterizer
+	Mesh testMesh
 	{
-		Mesh{
-			{
-				Vertex{{ -3.f, 3.f, -2.f }, {0, 0, 0}, {0.0f, 0.0f}},
-				Vertex{{ 0.f, 3.f, -2.f }, {0, 0, 0}, { 0.5f, 0.0f }},
-				Vertex{{ 3.f, 3.f, -2.f }, {0, 0, 0}, { 1.0f, 0.0f }},
-				Vertex{{ -3.f, 0.f, -2.f }, {0, 0, 0}, { 0.0f, 0.5f }},
-				Vertex{{ 0.f, 0.f, -2.f }, {0, 0, 0}, { 0.5f, 0.5f }},
-				Vertex{{ 3.f, 0.f, -2.f }, {0, 0, 0}, { 1.0f, 0.5f }},
-				Vertex{{ -3.f, -3.f, -2.f }, {0, 0, 0}, { 0.0f, 1.0f }},
-				Vertex{{ 0.f, -3.f, -2.f }, {0, 0, 0}, { 0.5f, 1.0f }},
-				Vertex{{ 3.f, -3.f, -2.f }, {0, 0, 0}, { 1.0f, 1.0f }},
+		{
+			Vertex{{ -3.f, 3.f, -2.f }, {0, 0, 0}, {0.0f, 0.0f}},
+			Vertex{{ 0.f, 3.f, -2.f }, {0, 0, 0}, { 0.5f, 0.0f }},
+			Vertex{{ 3.f, 3.f, -2.f }, {0, 0, 0}, { 1.0f, 0.0f }},
+			Vertex{{ -3.f, 0.f, -2.f }, {0, 0, 0}, { 0.0f, 0.5f }},
+			Vertex{{ 0.f, 0.f, -2.f }, {0, 0, 0}, { 0.5f, 0.5f }},
+			Vertex{{ 3.f, 0.f, -2.f }, {0, 0, 0}, { 1.0f, 0.5f }},
+			Vertex{{ -3.f, -3.f, -2.f }, {0, 0, 0}, { 0.0f, 1.0f }},
+			Vertex{{ 0.f, -3.f, -2.f }, {0, 0, 0}, { 0.5f, 1.0f }},
+			Vertex{{ 3.f, -3.f, -2.f }, {0, 0, 0}, { 1.0f, 1.0f }},
 		},
-				{
+		{
 			3, 0, 4, 1, 5, 2,
 			2, 6,
 			6, 3, 7, 4, 8, 5
 		},
 
 		PrimitiveTopology::TriangleStrip
-		}
 	};
-#else
-	Utils::ParseOBJ("Resources/vehicle.obj", m_Mesh.vertices, m_Mesh.indices);
+	testMesh.bounds = Utils::CalculateBounds(testMesh.vertices);
 
-	m_Mesh.primitiveTopology = PrimitiveTopology::TriangeList;
+	//The first run parses the obj and writes its mesh file, later runs only map that file
+	//Without a writable mesh file the vehicle keeps the parsed obj in memory instead
+	Mesh vehicleMesh{};
+	m_pMeshFile = MeshFile::LoadOBJ("Resources/vehicle.obj", vehicleMesh, m_pThreadPool);
 
 	const Vector3 position{ Vector3{0.0f, 0.0f, 50.0f} };
-	m_Mesh.worldMatrix = Matrix::CreateTranslation(position);
+	vehicleMesh.worldMatrix = Matrix::CreateTranslation(position);
 
+	//ToggleMesh swaps in the other one
+#ifdef UseTriangleStruct
+	m_Mesh = std::move(testMesh);
+	m_InactiveMesh = std::move(vehicleMesh);
+#else
+	m_Mesh = std::move(vehicleMesh);
+	m_InactiveMesh = std::move(testMesh);
 #endif // UseTriangleStruct
+
+	ReserveFrameArena();
+}
+
+void dae::Renderer::ReserveFrameArena()
+{
+	const size_t indexCount{ m_Mesh.GetIndices().size() };
+	const size_t triangleCount{ m_Mesh.primitiveTopology == PrimitiveTopology::TriangleStrip ? std::max(indexCount, size_t{ 2 }) - 2 : indexCount / 3 };
+
+	//Screen positions and clip codes per vertex, then the triangles and their tile bins, assuming a triangle overlaps two tiles
+	const size_t frameSize
+	{
+		m_Mesh.GetVertices().size() * (sizeof(Vector2) + sizeof(uint16_t))
+		+ triangleCount * (sizeof(Triangle) + 2 * sizeof(int))
+		+ (2 * static_cast<size_t>(m_TileCount) + 1) * sizeof(int)
+	};
+
+	//Same headroom the arena adds when it grows, for triangles clipping splits up and the alignment between the arrays
+	m_pFrameArena->Reserve(frameSize + frameSize / 2);
+}
+
+void dae::Renderer::ToggleMesh()
+{
+	std::swap(m_Mesh, m_InactiveMesh);
+	ReserveFrameArena();
+
+	//vertices_out grows to the new mesh on its first frame
+	m_WarmUpFrameCount = 1;
+
+	PrintMesh();
+}
+
+void dae::Renderer::SetMesh(const Mesh& mesh)
+{
+	m_Mesh = mesh;
+	m_Mesh.bounds = Utils::CalculateBounds(m_Mesh.GetVertices());
+	ReserveFrameArena();
+	m_WarmUpFrameCount = 1;
 }
 
 Renderer::~Renderer()
 {
-	delete[] m_pDepthBufferPixels;
+	//Only frees the surface, in headless mode the pixels belong to the caller
+	SDL_FreeSurface(m_pBackBuffer);
+	m_pBackBuffer = nullptr;
+
+	if (m_OwnsDepthBuffer)
+		delete[] m_pDepthBufferPixels;
+	delete[] m_pGBuffer;
+	delete[] m_pHiZBuffer;
+
+	delete m_pThreadPool;
+	m_pThreadPool = nullptr;
 
+	delete m_pMeshFile;
+	m_pMeshFile = nullptr;
+
+	delete m_pFrameArena;
+	m_pFrameArena = nullptr;
 
 	delete m_pDiffuseTexture;
 	m_pDiffuseTexture = nullptr;
@@ -98,6 +301,9 @@ Renderer::~Renderer()
 
 	delete m_pNormalMap;
 	m_pNormalMap = nullptr;
+
+	delete m_pMaterialTexture;
+	m_pMaterialTexture = nullptr;
 }
 
 void Renderer::Update(Timer* pTimer)
@@ -112,96 +318,515 @@ void Renderer::Update(Timer* pTimer)
 
 void Renderer::Render()
 {
+	if (!m_IsInitialized)
+		return;
+
+	//Everything from the previous frame's arena is dead by now
+	//Reset grows the block after a frame that overflowed it, that reallocation belongs to the frame that overflowed
+	m_pFrameArena->Reset();
+
+	const uint64_t allocationCountStart{ AllocationCounter::GetCount() };
+
+	SelectPermutation();
+
 	//@START
 	SDL_FillRect(m_pBackBuffer, NULL, SDL_MapRGB(m_pBackBuffer->format, 100, 100, 100));
 	std::fill_n(m_pDepthBufferPixels, m_Width * m_Height, FLT_MAX);
+	std::fill_n(m_pHiZBuffer, m_HiZWidth * m_HiZHeight, FLT_MAX);
 	//Lock BackBuffer
 	SDL_LockSurface(m_pBackBuffer);
 
 	RenderMesh(m_Mesh);
 
+	//Deferred mode only filled the G-buffer, shade every visible pixel once now
+	if (m_RenderPath == RenderPath::Deferred && !m_RenderBoundingBox)
+		ResolveGBuffer();
+
 	//@END
 	//Update SDL Surface
 	SDL_UnlockSurface(m_pBackBuffer);
-	SDL_BlitSurface(m_pBackBuffer, 0, m_pFrontBuffer, 0);
-	SDL_UpdateWindowSurface(m_pWindow);
+	if (m_pWindow)
+	{
+		SDL_BlitSurface(m_pBackBuffer, 0, m_pFrontBuffer, 0);
+		SDL_UpdateWindowSurface(m_pWindow);
+	}
+
+	m_LastFrameAllocationCount = AllocationCounter::GetCount() - allocationCountStart;
+
+	//Once the mesh has been rendered once, per frame memory comes from the arena or from storage that is already big enough
+	assert((m_WarmUpFrameCount > 0 || m_pFrameArena->HasOverflowed() || m_LastFrameAllocationCount == 0) && "Steady state frame allocated on the heap");
+
+	if (m_WarmUpFrameCount > 0)
+		--m_WarmUpFrameCount;
 }
 
 void dae::Renderer::RenderMesh(Mesh& mesh)
 {
-	VertexTransformationFunction(mesh);
+	//Nothing of a mesh outside the frustum can reach the screen, skip it before a single vertex gets transformed
+	if (IsOutsideFrustum(mesh))
+	{
+		m_TriangleCount = 0;
+		return;
+	}
 
-	std::vector<Vector2> vertices_ScreenSpace{};
+	const size_t vertexCount{ mesh.GetVertices().size() };
+	Vector2* vertices_ScreenSpace{ m_pFrameArena->Allocate<Vector2>(vertexCount) };
+	uint16_t* pClipCodes{ m_pFrameArena->Allocate<uint16_t>(vertexCount) };
 
-	for (const auto& vertex : mesh.vertices_out)
+	VertexTransformationFunction(mesh, vertices_ScreenSpace, pClipCodes);
+
+#ifdef UseTriangleStruct
+	GatherTriangles(mesh, vertices_ScreenSpace, pClipCodes);
+
+	if (m_UseMultithreading)
 	{
-		vertices_ScreenSpace.push_back(
+		BinTriangles();
+
+		m_pThreadPool->ParallelFor(m_TileCount, [this](int tileIdx)
 			{
-				(vertex.position.x + 1) / 2.0f * m_Width,
-				(1.0f - vertex.position.y) / 2.0f * m_Height
+				RenderTile(tileIdx);
 			});
 	}
+	else
+	{
+		const Tile screen{ 0, 0, m_Width, m_Height };
 
-	Triangle triangle{};
-
+		for (int i{}; i < m_TriangleCount; ++i)
+		{
+			(this->*m_pPermutation->renderTriangle)(m_pTriangles[i], screen);
+		}
+	}
+#else
 	switch (mesh.primitiveTopology)
 	{
 	case PrimitiveTopology::TriangeList:
-		for (int i{}; i < mesh.indices.size(); i += 3)
+		for (int i{}; i < mesh.GetIndices().size(); i += 3)
 		{
-#ifdef UseTriangleStruct
-			if (CalculateTriangle(triangle, mesh, vertices_ScreenSpace, i))
-			{
-				RenderTriangle(triangle);
-			}
-#else
-			RenderTriangle(mesh, vertices_ScreenSpace, i);
-#endif // UseTriangleStruct
-
+			(this->*m_pPermutation->renderMeshTriangle)(mesh, vertices_ScreenSpace, i, false);
 		}
 		break;
 	case PrimitiveTopology::TriangleStrip:
-		for (int i{}; i < mesh.indices.size() - 2; i++)
+		for (int i{}; i < mesh.GetIndices().size() - 2; i++)
 		{
-#ifdef UseTriangleStruct
-			if (CalculateTriangle(triangle, mesh, vertices_ScreenSpace, i, (i%2) == 1))
-			{
-				RenderTriangle(triangle);
-			}
-#else
-			RenderTriangle(mesh, vertices_ScreenSpace, i, (i % 2) == 1);
-#endif
+			(this->*m_pPermutation->renderMeshTriangle)(mesh, vertices_ScreenSpace, i, (i % 2) == 1);
 		}
 		break;
 	default:
 		break;
 	}
+#endif // UseTriangleStruct
+}
+
+bool dae::Renderer::IsOutsideFrustum(const Mesh& mesh) const
+{
+	//Rows of the transpose are what clip x, y, z and w are dotted with, so the clip planes come out in object space
+	//A point is inside a plane where Dot({ point, 1 }, plane) >= 0
+	const Matrix clipColumns{ Matrix::Transpose(mesh.worldMatrix * m_Camera.viewMatrix * m_Camera.projectionMatrix) };
+
+	const Vector4 planes[]
+	{
+		clipColumns[3] + clipColumns[0], //left
+		clipColumns[3] - clipColumns[0], //right
+		clipColumns[3] + clipColumns[1], //bottom
+		clipColumns[3] - clipColumns[1], //top
+		clipColumns[2], //near
+		clipColumns[3] - clipColumns[2] //far
+	};
+
+	const MeshBounds& bounds{ mesh.bounds };
+
+	for (const Vector4& plane : planes)
+	{
+		const Vector3 normal{ plane.GetXYZ() };
+
+		//The sphere only takes a dot product, the box is tighter for long meshes
+		if (Vector3::Dot(normal, bounds.center) + plane.w < -bounds.radius * normal.Magnitude())
+			return true;
+
+		//Corner furthest along the normal, when even that one is outside so is the whole box
+		const Vector3 corner
+		{
+			normal.x >= 0.f ? bounds.max.x : bounds.min.x,
+			normal.y >= 0.f ? bounds.max.y : bounds.min.y,
+			normal.z >= 0.f ? bounds.max.z : bounds.min.z
+		};
+
+		if (Vector3::Dot(normal, corner) + plane.w < 0.f)
+			return true;
+	}
+
+	return false;
+}
+
+void dae::Renderer::GatherTriangles(const Mesh& mesh, const Vector2* vertices_ScreenSpace, const uint16_t* pClipCodes)
+{
+	const Matrix worldViewProjection{ mesh.worldMatrix * m_Camera.viewMatrix * m_Camera.projectionMatrix };
+
+	//Calls function with the vertex indices of every triangle, in the winding the rasterizer expects
+	const std::span<const uint32_t> indices{ mesh.GetIndices() };
+	const auto forEachTriangle = [&mesh, indices](const auto& function)
+		{
+			switch (mesh.primitiveTopology)
+			{
+			case PrimitiveTopology::TriangeList:
+				for (size_t i{}; i + 2 < indices.size(); i += 3)
+				{
+					function(indices[i], indices[i + 1], indices[i + 2]);
+				}
+				break;
+			case PrimitiveTopology::TriangleStrip:
+				for (size_t i{}; i + 2 < indices.size(); ++i)
+				{
+					//Every other triangle of a strip has the opposite winding
+					const bool flipTriangle{ (i % 2) == 1 };
+					function(indices[i], indices[i + 1 + flipTriangle], indices[i + 2 - flipTriangle]);
+				}
+				break;
+			default:
+				break;
+			}
+		};
+
+	//Clipping makes at most one more triangle per crossed plane, reserve room for that first
+	int maxTriangleCount{};
+	forEachTriangle([&](uint32_t index0, uint32_t index1, uint32_t index2)
+		{
+			const uint16_t crossedPlanes{ static_cast<uint16_t>((pClipCodes[index0] | pClipCodes[index1] | pClipCodes[index2]) & ClipMask) };
+			maxTriangleCount += 1 + std::popcount(crossedPlanes);
+		});
+
+	m_pTriangles = m_pFrameArena->Allocate<Triangle>(maxTriangleCount);
+	m_TriangleCount = 0;
+
+	forEachTriangle([&](uint32_t index0, uint32_t index1, uint32_t index2)
+		{
+			if (index0 == index1 || index1 == index2 || index2 == index0)
+				return;
+
+			const uint16_t clipCode0{ pClipCodes[index0] };
+			const uint16_t clipCode1{ pClipCodes[index1] };
+			const uint16_t clipCode2{ pClipCodes[index2] };
+
+			//All three vertices on the outside of the same plane, nothing of the triangle can be visible
+			if (clipCode0 & clipCode1 & clipCode2 & TrivialRejectMask)
+				return;
+
+			const uint16_t crossedPlanes{ static_cast<uint16_t>((clipCode0 | clipCode1 | clipCode2) & ClipMask) };
+			if (crossedPlanes)
+			{
+				const uint32_t indices[3]{ index0, index1, index2 };
+				m_TriangleCount += ClipTriangle(m_pTriangles + m_TriangleCount, mesh, worldViewProjection, indices, crossedPlanes);
+				return;
+			}
+
+			Triangle& triangle{ m_pTriangles[m_TriangleCount] };
+
+			triangle.screen[0] = { vertices_ScreenSpace[index0] };
+			triangle.screen[1] = { vertices_ScreenSpace[index1] };
+			triangle.screen[2] = { vertices_ScreenSpace[index2] };
+
+			triangle.ndc[0] = mesh.vertices_out[index0];
+			triangle.ndc[1] = mesh.vertices_out[index1];
+			triangle.ndc[2] = mesh.vertices_out[index2];
+
+			if (SetupTriangle(triangle))
+				++m_TriangleCount;
+		});
+}
+
+void dae::Renderer::BinTriangles()
+{
+	//Two passes so the bins can be packed into one flat array: count, then fill
+	m_pTileBinOffsets = m_pFrameArena->Allocate<int>(m_TileCount + 1);
+	std::fill_n(m_pTileBinOffsets, m_TileCount + 1, 0);
+
+	const auto forEachOverlappedTile = [this](const BoundingBox& box, const auto& function)
+		{
+			//Bounding box max is exclusive, clamp to the tiles that exist
+			const int minTileX{ std::max(box.minX, 0) / m_TileSize };
+			const int minTileY{ std::max(box.minY, 0) / m_TileSize };
+			const int maxTileX{ std::min((box.maxX - 1) / m_TileSize, m_TileCountX - 1) };
+			const int maxTileY{ std::min((box.maxY - 1) / m_TileSize, m_TileCountY - 1) };
+
+			for (int tileY{ minTileY }; tileY <= maxTileY; ++tileY)
+			{
+				for (int tileX{ minTileX }; tileX <= maxTileX; ++tileX)
+				{
+					function(tileX + tileY * m_TileCountX);
+				}
+			}
+		};
+
+	for (int triangleIdx{}; triangleIdx < m_TriangleCount; ++triangleIdx)
+	{
+		forEachOverlappedTile(m_pTriangles[triangleIdx].boundingBox, [this](int tileIdx)
+			{
+				++m_pTileBinOffsets[tileIdx + 1];
+			});
+	}
+
+	for (int tileIdx{}; tileIdx < m_TileCount; ++tileIdx)
+	{
+		m_pTileBinOffsets[tileIdx + 1] += m_pTileBinOffsets[tileIdx];
+	}
+
+	m_pTileBinTriangles = m_pFrameArena->Allocate<int>(m_pTileBinOffsets[m_TileCount]);
+
+	//Fill cursors start at the offsets, triangles keep their submission order within a bin
+	int* pFillCursors{ m_pFrameArena->Allocate<int>(m_TileCount) };
+	std::copy_n(m_pTileBinOffsets, m_TileCount, pFillCursors);
+
+	for (int triangleIdx{}; triangleIdx < m_TriangleCount; ++triangleIdx)
+	{
+		forEachOverlappedTile(m_pTriangles[triangleIdx].boundingBox, [&](int tileIdx)
+			{
+				m_pTileBinTriangles[pFillCursors[tileIdx]++] = triangleIdx;
+			});
+	}
+}
+
+void dae::Renderer::RenderTile(int tileIdx)
+{
+	const int tileX{ tileIdx % m_TileCountX };
+	const int tileY{ tileIdx / m_TileCountX };
+
+	const Tile tile
+	{
+		tileX * m_TileSize,
+		tileY * m_TileSize,
+		std::min((tileX + 1) * m_TileSize, m_Width),
+		std::min((tileY + 1) * m_TileSize, m_Height)
+	};
+
+	//Triangles were binned in submission order, so every pixel sees the same sequence as the single threaded path
+	for (int binIdx{ m_pTileBinOffsets[tileIdx] }; binIdx < m_pTileBinOffsets[tileIdx + 1]; ++binIdx)
+	{
+		(this->*m_pPermutation->renderTriangle)(m_pTriangles[m_pTileBinTriangles[binIdx]], tile);
+	}
+}
+
+int dae::Renderer::ClipTriangle(Triangle* pTriangles, const Mesh& mesh, const Matrix& worldViewProjection, const uint32_t* pIndices, uint16_t crossedPlanes)
+{
+	//The divided positions of vertices behind the camera are useless, clip in homogeneous clip space instead
+	//Attributes are linear there too, so they get interpolated alongside the positions
+	Vertex_Out polygons[2][MaxClipVertexCount];
+	int vertexCount{ 3 };
+
+	for (int i{}; i < 3; ++i)
+	{
+		polygons[0][i] = mesh.vertices_out[pIndices[i]];
+		polygons[0][i].position = worldViewProjection.TransformPoint({ mesh.GetVertices()[pIndices[i]].position, 1.f });
+	}
+
+	//Distance to the plane, positive on the inside
+	const auto planeDistance = [this](uint16_t plane, const Vector4& position)
+		{
+			switch (plane)
+			{
+			case ClipNear:
+				return position.w - m_Camera.nearPlane;
+			case ClipGuardLeft:
+				return position.x + m_GuardBand.x * position.w;
+			case ClipGuardRight:
+				return m_GuardBand.x * position.w - position.x;
+			case ClipGuardBottom:
+				return position.y + m_GuardBand.y * position.w;
+			case ClipGuardTop:
+				return m_GuardBand.y * position.w - position.y;
+			default:
+				return 0.f;
+			}
+		};
+
+	int inputIdx{};
+
+	for (uint16_t remainingPlanes{ crossedPlanes }; remainingPlanes; remainingPlanes &= remainingPlanes - 1)
+	{
+		const uint16_t plane{ static_cast<uint16_t>(1 << std::countr_zero(remainingPlanes)) };
+
+		const Vertex_Out* pInput{ polygons[inputIdx] };
+		Vertex_Out* pOutput{ polygons[1 - inputIdx] };
+		int outputCount{};
+
+		//A convex polygon gains at most one vertex per plane, anything past that would be rounding noise
+		const auto output = [&](const Vertex_Out& vertex)
+			{
+				if (outputCount <= vertexCount)
+					pOutput[outputCount++] = vertex;
+			};
+
+		//Sutherland-Hodgman: keep the inside vertices and add one where an edge crosses the plane
+		for (int i{}; i < vertexCount; ++i)
+		{
+			const Vertex_Out& current{ pInput[i] };
+			const Vertex_Out& next{ pInput[(i + 1) % vertexCount] };
+
+			const float currentDistance{ planeDistance(plane, current.position) };
+			const float nextDistance{ planeDistance(plane, next.position) };
+
+			if (currentDistance >= 0.f)
+				output(current);
+
+			if ((currentDistance >= 0.f) != (nextDistance >= 0.f))
+				output(LerpVertex(current, next, currentDistance / (currentDistance - nextDistance)));
+		}
+
+		vertexCount = outputCount;
+		inputIdx = 1 - inputIdx;
+
+		if (vertexCount < 3)
+			return 0;
+	}
+
+	//Same divide and viewport mapping as the vertex stage
+	Vertex_Out* pPolygon{ polygons[inputIdx] };
+	Vector2 screen[MaxClipVertexCount];
+
+	for (int i{}; i < vertexCount; ++i)
+	{
+		Vector4& position{ pPolygon[i].position };
+		position.x /= position.w;
+		position.y /= position.w;
+		position.z /= position.w;
+
+		screen[i] =
+			{
+				(position.x + 1) / 2.0f * m_Width,
+				(1.0f - position.y) / 2.0f * m_Height
+			};
+	}
+
+	//Fan around the first vertex keeps the winding of the original triangle
+	int triangleCount{};
+
+	for (int i{ 1 }; i + 1 < vertexCount; ++i)
+	{
+		Triangle& triangle{ pTriangles[triangleCount] };
+
+		triangle.screen[0] = screen[0];
+		triangle.screen[1] = screen[i];
+		triangle.screen[2] = screen[i + 1];
+
+		triangle.ndc[0] = pPolygon[0];
+		triangle.ndc[1] = pPolygon[i];
+		triangle.ndc[2] = pPolygon[i + 1];
+
+		if (SetupTriangle(triangle))
+			++triangleCount;
+	}
+
+	return triangleCount;
 }
 
-bool dae::Renderer::CalculateTriangle(Triangle& triangle, const Mesh& mesh, std::vector<Vector2>& vertices_ScreenSpace, int startIdx, bool flipTriangle)
+bool dae::Renderer::SetupTriangle(Triangle& triangle)
 {
-	const uint32_t index0{ mesh.indices[startIdx] };
-	const uint32_t index1{ mesh.indices[startIdx + 1 + 1 * flipTriangle] };
-	const uint32_t index2{ mesh.indices[startIdx + 1 + 1 * !flipTriangle] };
+	//Snap to the fixed point grid the rasterizers work on, coverage is decided on the snapped positions only
+	const int subpixelBits{ m_SubpixelBits };
+	const int subpixelScale{ 1 << subpixelBits };
+
+	for (int i{}; i < 3; ++i)
+	{
+		triangle.fixedScreen[i] =
+		{
+			static_cast<int>(std::lrint(triangle.screen[i].x * subpixelScale)),
+			static_cast<int>(std::lrint(triangle.screen[i].y * subpixelScale))
+		};
+	}
+
+	const Int2& v0{ triangle.fixedScreen[0] };
+	const Int2& v1{ triangle.fixedScreen[1] };
+	const Int2& v2{ triangle.fixedScreen[2] };
+
+	//Twice the signed area, exact in fixed point, the rasterizers only cover pixels of positive, front facing, triangles
+	const int signedArea{ (v2.x - v1.x) * (v0.y - v2.y) - (v2.y - v1.y) * (v0.x - v2.x) };
+
+	if (signedArea == 0)
+		return false;
+
+	const bool isFrontFacing{ signedArea > 0 };
+
+	if ((m_CullMode == CullMode::Back && !isFrontFacing) || (m_CullMode == CullMode::Front && isFrontFacing))
+		return false;
+
+	//Pixels are sampled at their centres, the box runs from the first to the last pixel whose centre lies within the extent
+	const auto firstPixel = [=](int fixedMin) { return (fixedMin - subpixelScale / 2 + subpixelScale - 1) >> subpixelBits; };
+	const auto lastPixel = [=](int fixedMax) { return (fixedMax - subpixelScale / 2) >> subpixelBits; };
+
+	BoundingBox& boundingBox{ triangle.boundingBox };
+	boundingBox.minX = std::max(firstPixel(std::min(v0.x, std::min(v1.x, v2.x))), 0);
+	boundingBox.minY = std::max(firstPixel(std::min(v0.y, std::min(v1.y, v2.y))), 0);
+	boundingBox.maxX = std::min(lastPixel(std::max(v0.x, std::max(v1.x, v2.x))) + 1, m_Width);
+	boundingBox.maxY = std::min(lastPixel(std::max(v0.y, std::max(v1.y, v2.y))) + 1, m_Height);
+
+	//Slivers between two pixel centres and the parts of the guard band off screen hold no samples
+	if (boundingBox.minX >= boundingBox.maxX || boundingBox.minY >= boundingBox.maxY)
+		return false;
+
+	//Back faces that are kept get their winding flipped, so the rasterizers see them as front facing
+	if (!isFrontFacing)
+	{
+		std::swap(triangle.screen[1], triangle.screen[2]);
+		std::swap(triangle.fixedScreen[1], triangle.fixedScreen[2]);
+		std::swap(triangle.ndc[1], triangle.ndc[2]);
+	}
+
+	triangle.inverseFixedArea = 1.f / static_cast<float>(std::abs(signedArea));
+
+	//Weight of a vertex is the cross of the opposite edge with the point, so it changes by that edge per pixel
+	const Vector2 edgeV0V1{ triangle.screen[1] - triangle.screen[0] };
+	const Vector2 edgeV1V2{ triangle.screen[2] - triangle.screen[1] };
+	const Vector2 edgeV2V0{ triangle.screen[0] - triangle.screen[2] };
+
+	const float inverseTriangleArea{ 1.f / Vector2::Cross(edgeV1V2, edgeV2V0) };
+
+	const Vector2 weightDdx{ -edgeV1V2.y * inverseTriangleArea, -edgeV2V0.y * inverseTriangleArea };
+	const Vector2 weightDdy{ edgeV1V2.x * inverseTriangleArea, edgeV2V0.x * inverseTriangleArea };
+	const float weightV2Ddx{ -edgeV0V1.y * inverseTriangleArea };
+	const float weightV2Ddy{ edgeV0V1.x * inverseTriangleArea };
 
-	if (index0 == index1 || index1 == index2 || index2 == index0)return false;
+	const float inverseW0{ 1.f / triangle.ndc[0].position.w };
+	const float inverseW1{ 1.f / triangle.ndc[1].position.w };
+	const float inverseW2{ 1.f / triangle.ndc[2].position.w };
 
-	triangle.screen[0] = { vertices_ScreenSpace[index0] };
-	triangle.screen[1] = { vertices_ScreenSpace[index1] };
-	triangle.screen[2] = { vertices_ScreenSpace[index2] };
+	triangle.uvOverWDdx = weightDdx.x * inverseW0 * triangle.ndc[0].uv + weightDdx.y * inverseW1 * triangle.ndc[1].uv + weightV2Ddx * inverseW2 * triangle.ndc[2].uv;
+	triangle.uvOverWDdy = weightDdy.x * inverseW0 * triangle.ndc[0].uv + weightDdy.y * inverseW1 * triangle.ndc[1].uv + weightV2Ddy * inverseW2 * triangle.ndc[2].uv;
+	triangle.inverseWDdx = weightDdx.x * inverseW0 + weightDdx.y * inverseW1 + weightV2Ddx * inverseW2;
+	triangle.inverseWDdy = weightDdy.x * inverseW0 + weightDdy.y * inverseW1 + weightV2Ddy * inverseW2;
+
+	return true;
+}
+
+void dae::Renderer::SelectPermutation()
+{
+	//Every combination is instantiated and put in the table at compile time
+	static constexpr auto permutationTable
+	{
+		[]<int... indices>(std::integer_sequence<int, indices...>)
+		{
+			return std::array<PermutationFunctions, sizeof...(indices)>
+			{
+				PermutationFunctions
+				{
+					&Renderer::RenderTriangle<ShaderPermutation::FromIndex(indices).ForRasterizer()>,
+					&Renderer::RenderTriangle<ShaderPermutation::FromIndex(indices).ForRasterizer()>,
+					&Renderer::ResolveRows<ShaderPermutation::FromIndex(indices).ForResolve()>
+				}...
+			};
+		}(std::make_integer_sequence<int, ShaderPermutation::Count>{})
+	};
 
-	triangle.ndc[0] = mesh.vertices_out[index0];
-	triangle.ndc[1] = mesh.vertices_out[index1];
-	triangle.ndc[2] = mesh.vertices_out[index2];
+	const ShaderPermutation permutation{ m_ShadingMode, m_UseNormalMap, m_RenderFinalColor, m_RenderPath == RenderPath::Deferred, m_RenderBoundingBox, m_UseFastMath };
 
-	triangle.boundingBox = GetBoundingBox(triangle.screen[0], triangle.screen[1], triangle.screen[2]);
+	m_pPermutation = &permutationTable[permutation.ToIndex()];
 }
 
-void dae::Renderer::RenderTriangle(const Mesh& mesh, std::vector<Vector2>& vertices_ScreenSpace, int startIdx, bool flipTriangle)
+template<Renderer::ShaderPermutation permutation>
+void dae::Renderer::RenderTriangle(const Mesh& mesh, const Vector2* vertices_ScreenSpace, int startIdx, bool flipTriangle)
 {
-	const uint32_t index0{ mesh.indices[startIdx] };
-	const uint32_t index1{ mesh.indices[startIdx + 1 + 1 * flipTriangle] };
-	const uint32_t index2{ mesh.indices[startIdx + 1 + 1 * !flipTriangle] };
+	const std::span<const uint32_t> indices{ mesh.GetIndices() };
+	const uint32_t index0{ indices[startIdx] };
+	const uint32_t index1{ indices[startIdx + 1 + 1 * flipTriangle] };
+	const uint32_t index2{ indices[startIdx + 1 + 1 * !flipTriangle] };
 
 	if (index0 == index1 || index1 == index2 || index2 == index0)return;
 
@@ -231,13 +856,14 @@ void dae::Renderer::RenderTriangle(const Mesh& mesh, std::vector<Vector2>& verti
 
 	ColorRGB finalColor{};
 
-	for (int px{ boundingBox.minX }; px < boundingBox.maxX; ++px)
+	//Walk scanlines so consecutive pixels share cache lines in both buffers
+	for (int py{ boundingBox.minY }; py < boundingBox.maxY; ++py)
 	{
-		for (int py{ boundingBox.minY }; py < boundingBox.maxY; ++py)
+		for (int px{ boundingBox.minX }; px < boundingBox.maxX; ++px)
 		{
 			const int pixelIdx{ px + py * m_Width };
 
-			if (m_RenderBoundingBox)
+			if constexpr (permutation.renderBoundingBox)
 			{
 				finalColor = ColorRGB{ 1, 1, 1 };
 
@@ -280,7 +906,7 @@ void dae::Renderer::RenderTriangle(const Mesh& mesh, std::vector<Vector2>& verti
 
 			m_pDepthBufferPixels[pixelIdx] = interpolatedZDepth;
 
-			if (m_RenderFinalColor)
+			if constexpr (permutation.renderFinalColor)
 			{
 				const float interpolatedWDepth = 1.0f /
 					(weightV0 / ndc0.position.w +
@@ -315,7 +941,7 @@ void dae::Renderer::RenderTriangle(const Mesh& mesh, std::vector<Vector2>& verti
 					(weightV2 * ndc2.viewDirection / ndc2.position.w)) * interpolatedWDepth)
 				};
 
-				finalColor = PixelShading(pixelOut);
+				finalColor = PixelShading<permutation>(pixelOut);
 			}
 			else
 			{
@@ -336,219 +962,823 @@ void dae::Renderer::RenderTriangle(const Mesh& mesh, std::vector<Vector2>& verti
 	}
 }
 
-void dae::Renderer::RenderTriangle(const Triangle& triangle)
+template<Renderer::ShaderPermutation permutation>
+void dae::Renderer::RenderTriangle(const Triangle& triangle, const Tile& tile)
 {
-	if (m_Camera.isOutsideFrustum(triangle.ndc[0].position) ||
-		m_Camera.isOutsideFrustum(triangle.ndc[1].position) ||
-		m_Camera.isOutsideFrustum(triangle.ndc[2].position))
+	//Only touch the pixels of the bounding box that lie within the tile
+	const Tile area
 	{
-		return;
-	}
+		std::max(triangle.boundingBox.minX, tile.minX),
+		std::max(triangle.boundingBox.minY, tile.minY),
+		std::min(triangle.boundingBox.maxX, tile.maxX),
+		std::min(triangle.boundingBox.maxY, tile.maxY)
+	};
 
-	const Vector2 edgeV0V1{ triangle.screen[1] - triangle.screen[0] };
-	const Vector2 edgeV1V2{ triangle.screen[2] - triangle.screen[1] };
-	const Vector2 edgeV2V0{ triangle.screen[0] - triangle.screen[2] };
+	if constexpr (permutation.renderBoundingBox)
+	{
+		const uint32_t boxColor{ SDL_MapRGB(m_pBackBuffer->format, 255, 255, 255) };
 
-	const float inverseTriangleArea{ 1.f / Vector2::Cross(edgeV1V2,edgeV2V0) };
+		for (int py{ area.minY }; py < area.maxY; ++py)
+		{
+			for (int px{ area.minX }; px < area.maxX; ++px)
+			{
+				m_pBackBufferPixels[px + py * m_Width] = boxColor;
+			}
+		}
 
-	ColorRGB finalColor{};
+		return;
+	}
+
+	if (!m_UseHiZ)
+	{
+		RasterizeArea<permutation>(triangle, area);
+		return;
+	}
+
+	//The interpolated depth is a weighted harmonic mean of the vertex depths, so it never gets closer than the closest vertex
+	//Vertices behind the camera break that, those triangles can't be rejected
+	const float nearestDepth{ std::min(triangle.ndc[0].position.z, std::min(triangle.ndc[1].position.z, triangle.ndc[2].position.z)) };
+	const bool canReject{ nearestDepth > 0.f };
+
+	//Tiles are multiples of the block size, so every block is owned by a single tile
+	const int firstBlockX{ area.minX / m_HiZBlockSize };
+	const int lastBlockX{ (area.maxX - 1) / m_HiZBlockSize };
+	const int firstBlockY{ area.minY / m_HiZBlockSize };
+	const int lastBlockY{ (area.maxY - 1) / m_HiZBlockSize };
 
-	for (int px{ triangle.boundingBox.minX }; px < triangle.boundingBox.maxX; ++px)
+	//Every row of blocks is rasterized as a single strip between its first and last visible block,
+	//so the rasterizers keep working on long spans instead of 8 pixel pieces
+	for (int blockY{ firstBlockY }; blockY <= lastBlockY; ++blockY)
 	{
-		for (int py{ triangle.boundingBox.minY }; py < triangle.boundingBox.maxY; ++py)
+		const float* pHiZRow{ m_pHiZBuffer + blockY * m_HiZWidth };
+
+		//Everything in a block is already closer than this triangle can get
+		int firstVisibleX{ firstBlockX };
+		while (firstVisibleX <= lastBlockX && canReject && nearestDepth > pHiZRow[firstVisibleX])
+			++firstVisibleX;
+
+		if (firstVisibleX > lastBlockX)
+			continue;
+
+		int lastVisibleX{ lastBlockX };
+		while (canReject && nearestDepth > pHiZRow[lastVisibleX])
+			--lastVisibleX;
+
+		const Tile stripArea
 		{
-			const int pixelIdx{ px + py * m_Width };
+			std::max(firstVisibleX * m_HiZBlockSize, area.minX),
+			std::max(blockY * m_HiZBlockSize, area.minY),
+			std::min((lastVisibleX + 1) * m_HiZBlockSize, area.maxX),
+			std::min((blockY + 1) * m_HiZBlockSize, area.maxY)
+		};
 
-			if (m_RenderBoundingBox)
-			{
-				finalColor = ColorRGB{ 1, 1, 1 };
+		//Depth only ever gets closer, an untouched strip keeps its maxima
+		if (!RasterizeArea<permutation>(triangle, stripArea))
+			continue;
 
-				m_pBackBufferPixels[pixelIdx] = SDL_MapRGB(m_pBackBuffer->format,
-					static_cast<uint8_t>(finalColor.r * 255),
-					static_cast<uint8_t>(finalColor.g * 255),
-					static_cast<uint8_t>(finalColor.b * 255));
+		for (int blockX{ firstVisibleX }; blockX <= lastVisibleX; ++blockX)
+		{
+			UpdateHiZ(blockX, blockY);
+		}
+	}
+}
 
-				continue;
+template<Renderer::ShaderPermutation permutation>
+bool dae::Renderer::RasterizeArea(const Triangle& triangle, const Tile& area)
+{
+	switch (m_RasterizerMode)
+	{
+	case RasterizerMode::PerPixel:
+		return RasterizePerPixel<permutation>(triangle, area);
+	case RasterizerMode::Incremental:
+		return RasterizeIncremental<permutation>(triangle, area);
+	case RasterizerMode::Simd:
+		return RasterizeSimd<permutation>(triangle, area);
+	}
+
+	return false;
+}
+
+void dae::Renderer::UpdateHiZ(int blockX, int blockY)
+{
+	const int minX{ blockX * m_HiZBlockSize };
+	const int minY{ blockY * m_HiZBlockSize };
+	const int maxX{ std::min(minX + m_HiZBlockSize, m_Width) };
+	const int maxY{ std::min(minY + m_HiZBlockSize, m_Height) };
+
+	float maxDepth{};
+
+	for (int py{ minY }; py < maxY; ++py)
+	{
+		const float* pDepthRow{ m_pDepthBufferPixels + py * m_Width };
+
+		for (int px{ minX }; px < maxX; ++px)
+		{
+			maxDepth = std::max(maxDepth, pDepthRow[px]);
+		}
+	}
+
+	m_pHiZBuffer[blockX + blockY * m_HiZWidth] = maxDepth;
+}
+
+template<Renderer::ShaderPermutation permutation>
+bool dae::Renderer::RasterizePerPixel(const Triangle& triangle, const Tile& area)
+{
+	const float inverseTriangleArea{ triangle.inverseFixedArea };
+
+	bool hasWrittenDepth{ false };
+
+	const auto rasterizePixel = [&](int px, int py)
+		{
+			// Evaluate every edge from scratch at the centre of this pixel
+			const EdgeFunction edge01{ triangle.fixedScreen[0], triangle.fixedScreen[1], px, py, m_SubpixelBits };
+			const EdgeFunction edge12{ triangle.fixedScreen[1], triangle.fixedScreen[2], px, py, m_SubpixelBits };
+			const EdgeFunction edge20{ triangle.fixedScreen[2], triangle.fixedScreen[0], px, py, m_SubpixelBits };
+
+			if (!(edge01.Covers(edge01.value) && edge12.Covers(edge12.value) && edge20.Covers(edge20.value))) return;
+
+			hasWrittenDepth |= ShadePixel<permutation>(triangle, px, py,
+				static_cast<float>(edge12.value) * inverseTriangleArea,
+				static_cast<float>(edge20.value) * inverseTriangleArea,
+				static_cast<float>(edge01.value) * inverseTriangleArea);
+		};
+
+	//Pixels are independent, so the order only changes how the buffers get walked in memory
+	switch (m_TraversalOrder)
+	{
+	case TraversalOrder::ColumnMajor:
+		for (int px{ area.minX }; px < area.maxX; ++px)
+		{
+			for (int py{ area.minY }; py < area.maxY; ++py)
+			{
+				rasterizePixel(px, py);
+			}
+		}
+		break;
+	case TraversalOrder::RowMajor:
+		for (int py{ area.minY }; py < area.maxY; ++py)
+		{
+			for (int px{ area.minX }; px < area.maxX; ++px)
+			{
+				rasterizePixel(px, py);
 			}
+		}
+		break;
+	case TraversalOrder::Block:
+		for (int blockY{ area.minY }; blockY < area.maxY; blockY += m_TraversalBlockSize)
+		{
+			for (int blockX{ area.minX }; blockX < area.maxX; blockX += m_TraversalBlockSize)
+			{
+				const int blockMaxY{ std::min(blockY + m_TraversalBlockSize, area.maxY) };
+				const int blockMaxX{ std::min(blockX + m_TraversalBlockSize, area.maxX) };
 
-			const Vector2 point{ static_cast<float>(px), static_cast<float>(py) };
+				for (int py{ blockY }; py < blockMaxY; ++py)
+				{
+					for (int px{ blockX }; px < blockMaxX; ++px)
+					{
+						rasterizePixel(px, py);
+					}
+				}
+			}
+		}
+		break;
+	}
 
-			const Vector2 v0ToPoint{ point - triangle.screen[0] };
-			const Vector2 v1ToPoint{ point - triangle.screen[1] };
-			const Vector2 v2ToPoint{ point - triangle.screen[2] };
+	return hasWrittenDepth;
+}
 
-			// Calculate cross product from edge to start to point
-			const float edge01PointCross{ Vector2::Cross(edgeV0V1, v0ToPoint) };
-			const float edge12PointCross{ Vector2::Cross(edgeV1V2, v1ToPoint) };
-			const float edge20PointCross{ Vector2::Cross(edgeV2V0, v2ToPoint) };
+template<Renderer::ShaderPermutation permutation>
+bool dae::Renderer::RasterizeIncremental(const Triangle& triangle, const Tile& area)
+{
+	const float inverseTriangleArea{ triangle.inverseFixedArea };
 
-			if (!(edge01PointCross > 0 && edge12PointCross > 0 && edge20PointCross > 0)) continue;
+	//Cross(edge, point - start) is linear in the point, so moving one pixel only adds a constant
+	const EdgeFunction edge01{ triangle.fixedScreen[0], triangle.fixedScreen[1], area.minX, area.minY, m_SubpixelBits };
+	const EdgeFunction edge12{ triangle.fixedScreen[1], triangle.fixedScreen[2], area.minX, area.minY, m_SubpixelBits };
+	const EdgeFunction edge20{ triangle.fixedScreen[2], triangle.fixedScreen[0], area.minX, area.minY, m_SubpixelBits };
 
-			const float weightV0{ edge12PointCross * inverseTriangleArea };
-			const float weightV1{ edge20PointCross * inverseTriangleArea };
-			const float weightV2{ edge01PointCross * inverseTriangleArea };
+	int edge01Row{ edge01.value };
+	int edge12Row{ edge12.value };
+	int edge20Row{ edge20.value };
 
-			float interpolatedZDepth
+	bool hasWrittenDepth{ false };
+
+	for (int py{ area.minY }; py < area.maxY; ++py)
+	{
+		int edge01PointCross{ edge01Row };
+		int edge12PointCross{ edge12Row };
+		int edge20PointCross{ edge20Row };
+
+		bool hasCoveredPixel{ false };
+
+		for (int px{ area.minX }; px < area.maxX; ++px)
+		{
+			if (edge01.Covers(edge01PointCross) && edge12.Covers(edge12PointCross) && edge20.Covers(edge20PointCross))
 			{
-				1.0f /
-						(weightV0 / triangle.ndc[0].position.z +
-						weightV1 / triangle.ndc[1].position.z +
-						weightV2 / triangle.ndc[2].position.z)
-			};
+				hasCoveredPixel = true;
 
-			if (interpolatedZDepth < 0.0f || interpolatedZDepth > 1.0f ||
-				m_pDepthBufferPixels[pixelIdx] < interpolatedZDepth)
-				continue;
+				hasWrittenDepth |= ShadePixel<permutation>(triangle, px, py,
+					static_cast<float>(edge12PointCross) * inverseTriangleArea,
+					static_cast<float>(edge20PointCross) * inverseTriangleArea,
+					static_cast<float>(edge01PointCross) * inverseTriangleArea);
+			}
+			else if (hasCoveredPixel)
+			{
+				//A triangle is convex, once the span is left the rest of the row is outside
+				break;
+			}
 
-			m_pDepthBufferPixels[pixelIdx] = interpolatedZDepth;
+			edge01PointCross += edge01.stepX;
+			edge12PointCross += edge12.stepX;
+			edge20PointCross += edge20.stepX;
+		}
+
+		edge01Row += edge01.stepY;
+		edge12Row += edge12.stepY;
+		edge20Row += edge20.stepY;
+	}
+
+	return hasWrittenDepth;
+}
+
+template<Renderer::ShaderPermutation permutation>
+bool dae::Renderer::RasterizeSimd(const Triangle& triangle, const Tile& area)
+{
+	const float inverseTriangleArea{ triangle.inverseFixedArea };
+
+	const EdgeFunction edge01{ triangle.fixedScreen[0], triangle.fixedScreen[1], area.minX, area.minY, m_SubpixelBits };
+	const EdgeFunction edge12{ triangle.fixedScreen[1], triangle.fixedScreen[2], area.minX, area.minY, m_SubpixelBits };
+	const EdgeFunction edge20{ triangle.fixedScreen[2], triangle.fixedScreen[0], area.minX, area.minY, m_SubpixelBits };
+
+	RowKernelInput input{};
+	input.stepX01 = edge01.stepX;
+	input.stepX12 = edge12.stepX;
+	input.stepX20 = edge20.stepX;
+	input.threshold01 = edge01.threshold;
+	input.threshold12 = edge12.threshold;
+	input.threshold20 = edge20.threshold;
+	input.inverseTriangleArea = inverseTriangleArea;
+	input.inverseZ0 = 1.f / triangle.ndc[0].position.z;
+	input.inverseZ1 = 1.f / triangle.ndc[1].position.z;
+	input.inverseZ2 = 1.f / triangle.ndc[2].position.z;
+
+	int edge01Row{ edge01.value };
+	int edge12Row{ edge12.value };
+	int edge20Row{ edge20.value };
+
+	bool hasWrittenDepth{ false };
+
+	for (int py{ area.minY }; py < area.maxY; ++py)
+	{
+		float* pDepthRow{ m_pDepthBufferPixels + py * m_Width };
+
+		bool hasCoveredPixel{ false };
+
+		for (int blockX{ area.minX }; blockX < area.maxX; blockX += RasterKernels::MaxPixelsPerCall)
+		{
+			const int count{ std::min(RasterKernels::MaxPixelsPerCall, area.maxX - blockX) };
+			const int offsetX{ blockX - area.minX };
 
-			if (m_RenderFinalColor)
+			input.edge01 = edge01Row + offsetX * edge01.stepX;
+			input.edge12 = edge12Row + offsetX * edge12.stepX;
+			input.edge20 = edge20Row + offsetX * edge20.stepX;
+
+			//Coverage and depth are done for the whole block at once, only the survivors get shaded
+			uint32_t coveredMask{};
+			uint32_t passMask{ m_CoverageDepthKernel(input, count, pDepthRow + blockX, coveredMask) };
+
+			if (passMask)
+				hasWrittenDepth = true;
+
+			while (passMask)
 			{
-				const float interpolatedWDepth = 1.0f /
-					(weightV0 / triangle.ndc[0].position.w +
-						weightV1 / triangle.ndc[1].position.w +
-						weightV2 / triangle.ndc[2].position.w);
+				const int lane{ std::countr_zero(passMask) };
+				passMask &= passMask - 1;
+
+				const int edge01PointCross{ input.edge01 + lane * edge01.stepX };
+				const int edge12PointCross{ input.edge12 + lane * edge12.stepX };
+				const int edge20PointCross{ input.edge20 + lane * edge20.stepX };
+
+				ShadeFragment<permutation>(triangle, blockX + lane, py,
+					static_cast<float>(edge12PointCross) * inverseTriangleArea,
+					static_cast<float>(edge20PointCross) * inverseTriangleArea,
+					static_cast<float>(edge01PointCross) * inverseTriangleArea,
+					pDepthRow[blockX + lane]);
+			}
 
-				Pixel_Out pixelOut{ Vector4{float(px), float(py), interpolatedZDepth, interpolatedWDepth} };
+			//Same early out as the incremental mode, but per block
+			if (coveredMask)
+				hasCoveredPixel = true;
+			else if (hasCoveredPixel)
+				break;
+		}
 
-				pixelOut.uv = ((weightV0 * triangle.ndc[0].uv / triangle.ndc[0].position.w) +
-					(weightV1 * triangle.ndc[1].uv / triangle.ndc[1].position.w) +
-					(weightV2 * triangle.ndc[2].uv / triangle.ndc[2].position.w)) * interpolatedWDepth;
+		edge01Row += edge01.stepY;
+		edge12Row += edge12.stepY;
+		edge20Row += edge20.stepY;
+	}
 
-				pixelOut.normal =
-				{
-					(((weightV0 * triangle.ndc[0].normal / triangle.ndc[0].position.w) +
-					(weightV1 * triangle.ndc[1].normal / triangle.ndc[1].position.w) +
-					(weightV2 * triangle.ndc[2].normal / triangle.ndc[2].position.w)) * interpolatedWDepth)
-				};
-				pixelOut.normal.Normalize();
+	return hasWrittenDepth;
+}
 
-				pixelOut.tangent =
-				{
-					(((weightV0 * triangle.ndc[0].tangent / triangle.ndc[0].position.w) +
-					(weightV1 * triangle.ndc[1].tangent / triangle.ndc[1].position.w) +
-					(weightV2 * triangle.ndc[2].tangent / triangle.ndc[2].position.w)) * interpolatedWDepth)
-				};
+template<Renderer::ShaderPermutation permutation>
+bool dae::Renderer::ShadePixel(const Triangle& triangle, int px, int py, float weightV0, float weightV1, float weightV2)
+{
+	const int pixelIdx{ px + py * m_Width };
 
-				pixelOut.viewDirection =
-				{
-					(((weightV0 * triangle.ndc[0].viewDirection / triangle.ndc[0].position.w) +
-					(weightV1 * triangle.ndc[1].viewDirection / triangle.ndc[1].position.w) +
-					(weightV2 * triangle.ndc[2].viewDirection / triangle.ndc[2].position.w)) * interpolatedWDepth)
-				};
+	float interpolatedZDepth
+	{
+		1.0f /
+				(weightV0 / triangle.ndc[0].position.z +
+				weightV1 / triangle.ndc[1].position.z +
+				weightV2 / triangle.ndc[2].position.z)
+	};
+
+	if (interpolatedZDepth < 0.0f || interpolatedZDepth > 1.0f ||
+		m_pDepthBufferPixels[pixelIdx] < interpolatedZDepth)
+		return false;
+
+	m_pDepthBufferPixels[pixelIdx] = interpolatedZDepth;
+
+	ShadeFragment<permutation>(triangle, px, py, weightV0, weightV1, weightV2, interpolatedZDepth);
+
+	return true;
+}
+
+template<Renderer::ShaderPermutation permutation>
+void dae::Renderer::ShadeFragment(const Triangle& triangle, int px, int py, float weightV0, float weightV1, float weightV2, float interpolatedZDepth)
+{
+	const int pixelIdx{ px + py * m_Width };
+
+	if constexpr (permutation.deferred)
+	{
+		//Depth is already in the depth buffer, the rest is only needed to shade
+		if constexpr (permutation.renderFinalColor)
+		{
+			const Pixel_Out pixelOut{ InterpolatePixel<permutation>(triangle, px, py, weightV0, weightV1, weightV2, interpolatedZDepth) };
+
+			GBufferTexel& texel{ m_pGBuffer[pixelIdx] };
+			texel.uv = pixelOut.uv;
+			texel.uvDdx = pixelOut.uvDdx;
+			texel.uvDdy = pixelOut.uvDdy;
+			texel.normal = GBuffer::PackUnitVector(pixelOut.normal);
+			texel.tangent = pixelOut.tangent;
+			texel.viewDirection = pixelOut.viewDirection;
+		}
+
+	}
+	else
+	{
+		ColorRGB finalColor{};
+
+		if constexpr (permutation.renderFinalColor)
+		{
+			Pixel_Out pixelOut{ InterpolatePixel<permutation>(triangle, px, py, weightV0, weightV1, weightV2, interpolatedZDepth) };
+
+			finalColor = PixelShading<permutation>(pixelOut);
+		}
+		else
+		{
+			const float depthColor{ Remap(interpolatedZDepth, 0.997f, 1.0f) };
+
+			finalColor = { depthColor, depthColor , depthColor };
+		}
+
+		WritePixel(pixelIdx, finalColor);
+	}
+}
+
+template<Renderer::ShaderPermutation permutation>
+Pixel_Out dae::Renderer::InterpolatePixel(const Triangle& triangle, int px, int py, float weightV0, float weightV1, float weightV2, float interpolatedZDepth) const
+{
+	if constexpr (permutation.useFastMath)
+	{
+		//One reciprocal per vertex instead of a divide per vertex and attribute
+		const float weightOverW0{ weightV0 * FastMath::Reciprocal(triangle.ndc[0].position.w) };
+		const float weightOverW1{ weightV1 * FastMath::Reciprocal(triangle.ndc[1].position.w) };
+		const float weightOverW2{ weightV2 * FastMath::Reciprocal(triangle.ndc[2].position.w) };
+
+		const float interpolatedWDepth{ FastMath::Reciprocal(weightOverW0 + weightOverW1 + weightOverW2) };
+
+		Pixel_Out pixelOut{ Vector4{float(px), float(py), interpolatedZDepth, interpolatedWDepth} };
 
-				finalColor = m_pDiffuseTexture->Sample(pixelOut.uv);
+		pixelOut.uv = (weightOverW0 * triangle.ndc[0].uv + weightOverW1 * triangle.ndc[1].uv + weightOverW2 * triangle.ndc[2].uv) * interpolatedWDepth;
 
-				//finalColor = PixelShading(pixelOut);
+		pixelOut.uvDdx = (triangle.uvOverWDdx - pixelOut.uv * triangle.inverseWDdx) * interpolatedWDepth;
+		pixelOut.uvDdy = (triangle.uvOverWDdy - pixelOut.uv * triangle.inverseWDdy) * interpolatedWDepth;
+
+		//Normalized right after, the 1 / w scale doesn't matter
+		pixelOut.normal = weightOverW0 * triangle.ndc[0].normal + weightOverW1 * triangle.ndc[1].normal + weightOverW2 * triangle.ndc[2].normal;
+		FastMath::Normalize(pixelOut.normal);
+
+		pixelOut.tangent = (weightOverW0 * triangle.ndc[0].tangent + weightOverW1 * triangle.ndc[1].tangent + weightOverW2 * triangle.ndc[2].tangent) * interpolatedWDepth;
+		pixelOut.viewDirection = (weightOverW0 * triangle.ndc[0].viewDirection + weightOverW1 * triangle.ndc[1].viewDirection + weightOverW2 * triangle.ndc[2].viewDirection) * interpolatedWDepth;
+
+		return pixelOut;
+	}
+	else
+	{
+		const float interpolatedWDepth = 1.0f /
+			(weightV0 / triangle.ndc[0].position.w +
+				weightV1 / triangle.ndc[1].position.w +
+				weightV2 / triangle.ndc[2].position.w);
+
+		Pixel_Out pixelOut{ Vector4{float(px), float(py), interpolatedZDepth, interpolatedWDepth} };
+
+		pixelOut.uv = ((weightV0 * triangle.ndc[0].uv / triangle.ndc[0].position.w) +
+			(weightV1 * triangle.ndc[1].uv / triangle.ndc[1].position.w) +
+			(weightV2 * triangle.ndc[2].uv / triangle.ndc[2].position.w)) * interpolatedWDepth;
+
+		//Quotient rule on uv = (uv / w) / (1 / w)
+		pixelOut.uvDdx = (triangle.uvOverWDdx - pixelOut.uv * triangle.inverseWDdx) * interpolatedWDepth;
+		pixelOut.uvDdy = (triangle.uvOverWDdy - pixelOut.uv * triangle.inverseWDdy) * interpolatedWDepth;
+
+		pixelOut.normal =
+		{
+			(((weightV0 * triangle.ndc[0].normal / triangle.ndc[0].position.w) +
+			(weightV1 * triangle.ndc[1].normal / triangle.ndc[1].position.w) +
+			(weightV2 * triangle.ndc[2].normal / triangle.ndc[2].position.w)) * interpolatedWDepth)
+		};
+		pixelOut.normal.Normalize();
+
+		pixelOut.tangent =
+		{
+			(((weightV0 * triangle.ndc[0].tangent / triangle.ndc[0].position.w) +
+			(weightV1 * triangle.ndc[1].tangent / triangle.ndc[1].position.w) +
+			(weightV2 * triangle.ndc[2].tangent / triangle.ndc[2].position.w)) * interpolatedWDepth)
+		};
+
+		pixelOut.viewDirection =
+		{
+			(((weightV0 * triangle.ndc[0].viewDirection / triangle.ndc[0].position.w) +
+			(weightV1 * triangle.ndc[1].viewDirection / triangle.ndc[1].position.w) +
+			(weightV2 * triangle.ndc[2].viewDirection / triangle.ndc[2].position.w)) * interpolatedWDepth)
+		};
+
+		return pixelOut;
+	}
+}
+
+void dae::Renderer::WritePixel(int pixelIdx, ColorRGB finalColor)
+{
+	//Update Color in Buffer
+	finalColor.MaxToOne();
+
+	m_pBackBufferPixels[pixelIdx] = SDL_MapRGB(m_pBackBuffer->format,
+		static_cast<uint8_t>(finalColor.r * 255),
+		static_cast<uint8_t>(finalColor.g * 255),
+		static_cast<uint8_t>(finalColor.b * 255));
+}
+
+void dae::Renderer::ResolveGBuffer()
+{
+	if (!m_UseMultithreading)
+	{
+		(this->*m_pPermutation->resolveRows)(0, m_Height);
+		return;
+	}
+
+	//Every visible pixel costs about the same, so plain bands of rows balance well enough
+	m_pThreadPool->ParallelFor(m_TileCountY, [this](int bandIdx)
+		{
+			(this->*m_pPermutation->resolveRows)(bandIdx * m_TileSize, std::min((bandIdx + 1) * m_TileSize, m_Height));
+		});
+}
+
+template<Renderer::ShaderPermutation permutation>
+void dae::Renderer::ResolveRows(int minY, int maxY)
+{
+	for (int py{ minY }; py < maxY; ++py)
+	{
+		for (int px{}; px < m_Width; ++px)
+		{
+			const int pixelIdx{ px + py * m_Width };
+			const float depth{ m_pDepthBufferPixels[pixelIdx] };
+
+			//Depth is cleared to FLT_MAX, anything else means a triangle got through
+			if (depth > 1.0f)
+				continue;
+
+			ColorRGB finalColor{};
+
+			if constexpr (permutation.renderFinalColor)
+			{
+				const GBufferTexel& texel{ m_pGBuffer[pixelIdx] };
+
+				//w isn't stored, shading doesn't need it
+				Pixel_Out pixel{ Vector4{ float(px), float(py), depth, 1.f } };
+				pixel.uv = texel.uv;
+				pixel.uvDdx = texel.uvDdx;
+				pixel.uvDdy = texel.uvDdy;
+				pixel.normal = GBuffer::UnpackUnitVector(texel.normal);
+				pixel.tangent = texel.tangent;
+				pixel.viewDirection = texel.viewDirection;
+
+				finalColor = PixelShading<permutation>(pixel);
 			}
 			else
 			{
-				const float depthColor{ Remap(interpolatedZDepth, 0.997f, 1.0f) };
+				const float depthColor{ Remap(depth, 0.997f, 1.0f) };
 
 				finalColor = { depthColor, depthColor , depthColor };
 			}
 
-
-			//Update Color in Buffer
-			finalColor.MaxToOne();
-
-			m_pBackBufferPixels[px + (py * m_Width)] = SDL_MapRGB(m_pBackBuffer->format,
-				static_cast<uint8_t>(finalColor.r * 255),
-				static_cast<uint8_t>(finalColor.g * 255),
-				static_cast<uint8_t>(finalColor.b * 255));
+			WritePixel(pixelIdx, finalColor);
 		}
 	}
 }
 
-void Renderer::VertexTransformationFunction(Mesh& mesh) const
+void Renderer::VertexTransformationFunction(Mesh& mesh, Vector2* vertices_ScreenSpace, uint16_t* pClipCodes) const
 {
-	mesh.vertices_out.clear();
-	mesh.vertices_out.reserve(mesh.vertices.size());
+	const std::span<const Vertex> vertices{ mesh.GetVertices() };
+
+	//Only reallocates when the vertex count changes, every vertex gets overwritten below
+	mesh.vertices_out.resize(vertices.size());
 
 	Matrix worldprojectionMatrix{ mesh.worldMatrix * m_Camera.viewMatrix * m_Camera.projectionMatrix };
 
-	for (auto& vertex : mesh.vertices)
-	{
-		// Tranform the vertex using the inversed view matrix
-		Vertex_Out outVertex{worldprojectionMatrix.TransformPoint({vertex.position, 1.f})
-			, vertex.color, vertex.uv,
-			mesh.worldMatrix.TransformVector(vertex.normal).Normalized(),
-			mesh.worldMatrix.TransformVector(vertex.tangent).Normalized(),
-			worldprojectionMatrix.TransformPoint(vertex.viewDirection).Normalized()
-		};
+	const int vertexCount{ static_cast<int>(vertices.size()) };
+	const int chunkCount{ (vertexCount + m_VertexChunkSize - 1) / m_VertexChunkSize };
+
+	//Project every chunk to screen space right after transforming it, while its vertices are still in cache
+	const auto transformChunk = [&](int chunkIdx)
+		{
+			const int firstVertex{ chunkIdx * m_VertexChunkSize };
+			const int chunkVertexCount{ std::min(m_VertexChunkSize, vertexCount - firstVertex) };
+
+			m_VertexTransformKernel(worldprojectionMatrix, mesh.worldMatrix, vertices.data() + firstVertex, mesh.vertices_out.data() + firstVertex, chunkVertexCount);
+
+			for (int i{ firstVertex }; i < firstVertex + chunkVertexCount; ++i)
+			{
+				const Vertex_Out& vertex{ mesh.vertices_out[i] };
 
-		outVertex.position.x /= outVertex.position.w;
-		outVertex.position.y /= outVertex.position.w;
-		outVertex.position.z /= outVertex.position.w;
+				vertices_ScreenSpace[i] =
+					{
+						(vertex.position.x + 1) / 2.0f * m_Width,
+						(1.0f - vertex.position.y) / 2.0f * m_Height
+					};
 
-		// Add the new vertex to the list of NDC vertices
-		mesh.vertices_out.emplace_back(outVertex);
+				//In front of the near plane the clip space position is the divided one times w,
+				//behind it the divide flipped or blew it up, so transform it again
+				const Vector4 clipPosition
+				{
+					vertex.position.w >= m_Camera.nearPlane ?
+					Vector4{ vertex.position.x * vertex.position.w, vertex.position.y * vertex.position.w, vertex.position.z * vertex.position.w, vertex.position.w } :
+					worldprojectionMatrix.TransformPoint({ vertices[i].position, 1.f })
+				};
+
+				pClipCodes[i] = CalculateClipCode(clipPosition, m_Camera.nearPlane, m_GuardBand);
+			}
+		};
+
+	if (m_UseMultithreading && chunkCount > 1)
+	{
+		//std::ref keeps std::function from copying the lambda to the heap
+		m_pThreadPool->ParallelFor(chunkCount, std::ref(transformChunk));
+	}
+	else
+	{
+		for (int chunkIdx{}; chunkIdx < chunkCount; ++chunkIdx)
+		{
+			transformChunk(chunkIdx);
+		}
 	}
 }
 
+template<Renderer::ShaderPermutation permutation>
 ColorRGB dae::Renderer::PixelShading(Pixel_Out& pixel)
 {
+	const MaterialSample material{ SampleMaterial(pixel) };
+
 	Vector3 sampledNormal{pixel.normal};
-	if (m_UseNormalMap)
+	if constexpr (permutation.useNormalMap)
 	{
 		const Vector3 binormal{ Vector3::Cross(pixel.normal, pixel.tangent) };
-		const Matrix tangentSpaceAxis{ pixel.tangent, binormal.Normalized(), pixel.normal, {0.f, 0.f, 0.f} };
+		Vector3 normalizedBinormal{};
+		if constexpr (permutation.useFastMath)
+			normalizedBinormal = FastMath::Normalized(binormal);
+		else
+			normalizedBinormal = binormal.Normalized();
 
-		const ColorRGB normalColor{ m_pNormalMap->Sample(pixel.uv) };
+		const Matrix tangentSpaceAxis{ pixel.tangent, normalizedBinormal, pixel.normal, {0.f, 0.f, 0.f} };
+
+		const ColorRGB normalColor{ material.normal };
 		sampledNormal = { normalColor.r, normalColor.g, normalColor.b };
 
 		sampledNormal = 2 * sampledNormal - Vector3{ 1.f, 1.f, 1.f };
 		sampledNormal = tangentSpaceAxis.TransformVector(sampledNormal);
 	}
-	sampledNormal.Normalize();
+
+	if constexpr (permutation.useFastMath)
+		FastMath::Normalize(sampledNormal);
+	else
+		sampledNormal.Normalize();
 
 	const float observedArea{std::max(0.f, Vector3::Dot(sampledNormal, -m_LightDirection))};
 	const float kd{ .5f };
 
 	ColorRGB finalColor{};
 
-	switch (m_ShadingMode)
+	if constexpr (permutation.shadingMode == ShadingMode::ObservedArea)
 	{
-	case dae::Renderer::ShadingMode::ObservedArea:
 		finalColor = ColorRGB{ 1, 1, 1 } * observedArea;
-		break;
-	case dae::Renderer::ShadingMode::Diffuse:
+	}
+	else if constexpr (permutation.shadingMode == ShadingMode::Diffuse)
 	{
-		ColorRGB diffuse{ (m_pDiffuseTexture->Sample(pixel.uv) * kd) / PI * m_LightIntensity };
+		ColorRGB diffuse{ (material.diffuse * kd) / PI * m_LightIntensity };
 		finalColor = diffuse * observedArea;
 	}
-		break;
-	case dae::Renderer::ShadingMode::Specular:
+	else if constexpr (permutation.shadingMode == ShadingMode::Specular)
 	{
-		finalColor = CalculateSpecular(pixel, sampledNormal) * observedArea;
+		finalColor = CalculateSpecular<permutation>(pixel, sampledNormal, material) * observedArea;
 	}
-		break;
-	case dae::Renderer::ShadingMode::Combined:
-		ColorRGB diffuse{ (m_pDiffuseTexture->Sample(pixel.uv) * kd) / PI * m_LightIntensity };
+	else if constexpr (permutation.shadingMode == ShadingMode::Combined)
+	{
+		ColorRGB diffuse{ (material.diffuse * kd) / PI * m_LightIntensity };
 
-		finalColor = (diffuse *  observedArea) + CalculateSpecular(pixel, sampledNormal);
-		break;
+		finalColor = (diffuse *  observedArea) + CalculateSpecular<permutation>(pixel, sampledNormal, material);
 	}
 
 	return finalColor;
 }
 
-ColorRGB dae::Renderer::CalculateSpecular(const Pixel_Out& pixel, const Vector3& sampledNormal)
+template<Renderer::ShaderPermutation permutation>
+ColorRGB dae::Renderer::CalculateSpecular(const Pixel_Out& pixel, const Vector3& sampledNormal, const MaterialSample& material)
 {
 	const Vector3 reflect{ Vector3::Reflect(m_LightDirection, sampledNormal) };
 
 	const float cosAngle{ std::max(0.f, Vector3::Dot(reflect, -pixel.viewDirection)) };
 
-	const float exp{ m_pGlossTexture->Sample(pixel.uv).r * m_Shininess };
+	const float exp{ material.gloss * m_Shininess };
+
+	float phongSpecular{};
+	if constexpr (permutation.useFastMath)
+		phongSpecular = FastMath::Pow(cosAngle, exp);
+	else
+		phongSpecular = powf(cosAngle, exp);
+
+	return material.specular * phongSpecular;
+}
+
+MaterialSample dae::Renderer::SampleMaterial(const Pixel_Out& pixel) const
+{
+	if (m_UsePackedMaterial)
+		return m_pMaterialTexture->Sample(pixel.uv, pixel.uvDdx, pixel.uvDdy, m_TextureFilter);
+
+	return
+	{
+		m_pDiffuseTexture->Sample(pixel.uv, pixel.uvDdx, pixel.uvDdy, m_TextureFilter),
+		m_pGlossTexture ? m_pGlossTexture->Sample(pixel.uv, pixel.uvDdx, pixel.uvDdy, m_TextureFilter).r : TexelFormat::UnpackRGB(TexelFormat::FlatGloss).r,
+		m_pSpecularTexture ? m_pSpecularTexture->Sample(pixel.uv, pixel.uvDdx, pixel.uvDdy, m_TextureFilter) : TexelFormat::UnpackRGB(TexelFormat::FlatSpecular),
+		m_pNormalMap ? m_pNormalMap->Sample(pixel.uv, pixel.uvDdx, pixel.uvDdy, m_TextureFilter) : TexelFormat::UnpackRGB(TexelFormat::FlatNormal)
+	};
+}
+
+void dae::Renderer::SetTextureLayout(TextureLayout layout)
+{
+	Texture* pTextures[]{ m_pDiffuseTexture, m_pGlossTexture, m_pSpecularTexture, m_pNormalMap };
+	for (Texture* pTexture : pTextures)
+	{
+		if (pTexture)
+			pTexture->SetLayout(layout);
+	}
+
+	//The packed path samples only the material texture
+	if (m_pMaterialTexture)
+		m_pMaterialTexture->SetLayout(layout);
+}
+
+bool Renderer::SaveBufferToImage(const char* filePath) const
+{
+	return SDL_SaveBMP(m_pBackBuffer, filePath);
+}
+
+void dae::Renderer::PrintRasterizerMode()
+{
+	std::cout << "Rasterizer mode: ";
+
+	switch (m_RasterizerMode)
+	{
+	case dae::Renderer::RasterizerMode::PerPixel:
+		std::cout << "Per pixel \n";
+		break;
+	case dae::Renderer::RasterizerMode::Incremental:
+		std::cout << "Incremental \n";
+		break;
+	case dae::Renderer::RasterizerMode::Simd:
+		std::cout << "Simd (" << RasterKernels::GetKernelName(m_CoverageDepthKernel) << ") \n";
+		break;
+	default:
+		break;
+	}
+}
 
-	const float phongSpecular{ powf(cosAngle, exp) };
+void dae::Renderer::PrintTraversalOrder()
+{
+	std::cout << "Traversal order: ";
 
-	return m_pSpecularTexture->Sample(pixel.uv) * phongSpecular;
+	switch (m_TraversalOrder)
+	{
+	case dae::Renderer::TraversalOrder::ColumnMajor:
+		std::cout << "Column major \n";
+		break;
+	case dae::Renderer::TraversalOrder::RowMajor:
+		std::cout << "Row major \n";
+		break;
+	case dae::Renderer::TraversalOrder::Block:
+		std::cout << "Blocks of " << m_TraversalBlockSize << "x" << m_TraversalBlockSize << " \n";
+		break;
+	default:
+		break;
+	}
 }
 
-bool Renderer::SaveBufferToImage() const
+void dae::Renderer::PrintMesh()
 {
-	return SDL_SaveBMP(m_pBackBuffer, "Rasterizer_ColorBuffer.bmp");
+	const bool isMapped{ m_Mesh.vertices.empty() && !m_Mesh.mappedVertices.empty() };
+	std::cout << "Mesh: " << m_Mesh.GetVertices().size() << " vertices, " << (isMapped ? "mapped from its mesh file" : "in memory") << " \n";
+}
+
+void dae::Renderer::PrintHiZ()
+{
+	std::cout << "Hierarchical Z: " << (m_UseHiZ ? "on" : "off") << " \n";
+}
+
+void dae::Renderer::PrintCullMode()
+{
+	std::cout << "Cull mode: ";
+
+	switch (m_CullMode)
+	{
+	case dae::Renderer::CullMode::None:
+		std::cout << "None \n";
+		break;
+	case dae::Renderer::CullMode::Back:
+		std::cout << "Back \n";
+		break;
+	case dae::Renderer::CullMode::Front:
+		std::cout << "Front \n";
+		break;
+	default:
+		break;
+	}
+}
+
+void dae::Renderer::PrintRenderPath()
+{
+	std::cout << "Render path: ";
+
+	switch (m_RenderPath)
+	{
+	case dae::Renderer::RenderPath::Forward:
+		std::cout << "Forward \n";
+		break;
+	case dae::Renderer::RenderPath::Deferred:
+		std::cout << "Deferred \n";
+		break;
+	default:
+		break;
+	}
+}
+
+void dae::Renderer::PrintTextureFilter()
+{
+	std::cout << "Texture filter: ";
+
+	switch (m_TextureFilter)
+	{
+	case TextureFilter::Point:
+		std::cout << "Point \n";
+		break;
+	case TextureFilter::Bilinear:
+		std::cout << "Bilinear \n";
+		break;
+	case TextureFilter::Trilinear:
+		std::cout << "Trilinear \n";
+		break;
+	default:
+		break;
+	}
+}
+
+void dae::Renderer::PrintFastMath()
+{
+	std::cout << "Fast math: " << (m_UseFastMath ? "on" : "off") << " \n";
+}
+
+void dae::Renderer::PrintPackedMaterial()
+{
+	std::cout << "Packed material texture: " << (m_UsePackedMaterial ? "on" : "off") << " \n";
+}
+
+void dae::Renderer::PrintMultithreading()
+{
+	std::cout << "Multithreading: ";
+
+	if (m_UseMultithreading)
+		std::cout << "on (" << m_pThreadPool->GetThreadCount() << " threads, " << m_TileSize << "x" << m_TileSize << " tiles) \n";
+	else
+		std::cout << "off \n";
 }
 
 void dae::Renderer::PrintShadingMode()
@@ -6,6 +6,9 @@
 
 #include "Camera.h"
 #include "DataTypes.h"
+#include "RasterKernels.h"
+#include "Texture.h"
+#include "VertexKernels.h"
 
 struct SDL_Window;
 struct SDL_Surface;
@@ -13,15 +16,25 @@ struct SDL_Surface;
 namespace dae
 {
 	class Texture;
+	class MaterialTexture;
+	struct MaterialSample;
 	struct Mesh;
+	class MeshFile;
 	struct Vertex;
 	class Timer;
 	class Scene;
+	class ThreadPool;
+	struct GBufferTexel;
+	class FrameArena;
 
 	class Renderer final
 	{
 	public:
 		Renderer(SDL_Window* pWindow);
+
+		//Headless renderer, draws into caller-owned buffers of width * height pixels and needs no window nor SDL video subsystem
+		//Color is 0x00RRGGBB per pixel, row after row, both buffers have to outlive the renderer
+		Renderer(uint32_t* pColorBuffer, float* pDepthBuffer, int width, int height);
 		~Renderer();
 
 		Renderer(const Renderer&) = delete;
@@ -29,28 +42,110 @@ namespace dae
 		Renderer& operator=(const Renderer&) = delete;
 		Renderer& operator=(Renderer&&) noexcept = delete;
 
+		enum class ShadingMode
+		{
+			ObservedArea,
+			Diffuse,
+			Specular,
+			Combined
+		};
+
+		enum class RasterizerMode
+		{
+			PerPixel,
+			Incremental,
+			Simd
+		};
+
+		//Forward shades every fragment that passes the depth test,
+		//deferred writes a G-buffer and shades every visible pixel once afterwards
+		enum class RenderPath
+		{
+			Forward,
+			Deferred
+		};
+
+		//Which triangles setup throws away, front facing ones are clockwise on screen
+		enum class CullMode
+		{
+			None,
+			Back,
+			Front
+		};
+
+		//Order the per pixel rasterizer visits the pixels of a bounding box in
+		enum class TraversalOrder
+		{
+			ColumnMajor,
+			RowMajor,
+			Block
+		};
+
 		void Update(Timer* pTimer);
 		void Render();
 
-		bool SaveBufferToImage() const;
+		//Writes the color buffer as a bmp, returns false on success like SDL_SaveBMP
+		bool SaveBufferToImage(const char* filePath = "Rasterizer_ColorBuffer.bmp") const;
+
+		//Result of the last Render, width * height values row after row
+		const uint32_t* GetColorBuffer() const { return m_pBackBufferPixels; };
+		const float* GetDepthBuffer() const { return m_pDepthBufferPixels; };
+
+		int GetWidth() const { return m_Width; };
+		int GetHeight() const { return m_Height; };
 
 		void ToggleColor() { m_RenderFinalColor = !m_RenderFinalColor; };
 		void ToggleBoundingBox() { m_RenderBoundingBox = !m_RenderBoundingBox; };
 		void ToggleRotation() { m_RotationEnabled = !m_RotationEnabled; };
 		void ToggleNormal() { m_UseNormalMap = !m_UseNormalMap; };
+		void ToggleMultithreading() { m_UseMultithreading = !m_UseMultithreading; PrintMultithreading(); };
+		void ToggleHiZ() { m_UseHiZ = !m_UseHiZ; PrintHiZ(); };
+		void ToggleMesh();
+		void CycleRenderPath() { m_RenderPath = static_cast<RenderPath>((int(m_RenderPath) + 1) % 2); PrintRenderPath(); };
+		void CycleTextureFilter() { m_TextureFilter = static_cast<TextureFilter>((int(m_TextureFilter) + 1) % 3); PrintTextureFilter(); };
+		void ToggleFastMath() { m_UseFastMath = !m_UseFastMath; PrintFastMath(); };
+		void TogglePackedMaterial() { m_UsePackedMaterial = !m_UsePackedMaterial && m_pMaterialTexture; PrintPackedMaterial(); };
 		void CycleShading() { m_ShadingMode = static_cast<ShadingMode>((int(m_ShadingMode) + 1) % 4); PrintShadingMode(); };
+		void CycleCullMode() { m_CullMode = static_cast<CullMode>((int(m_CullMode) + 1) % 3); PrintCullMode(); };
+		void CycleRasterizerMode() { m_RasterizerMode = static_cast<RasterizerMode>((int(m_RasterizerMode) + 1) % 3); PrintRasterizerMode(); };
 
-		void PrintShadingMode();
+		void SetMesh(const Mesh& mesh);
+		void SetRotation(bool isEnabled) { m_RotationEnabled = isEnabled; };
+		void SetMultithreading(bool isEnabled) { m_UseMultithreading = isEnabled; };
+		void SetRasterizerMode(RasterizerMode mode) { m_RasterizerMode = mode; };
+		void SetTraversalOrder(TraversalOrder order) { m_TraversalOrder = order; };
+		void SetHiZ(bool isEnabled) { m_UseHiZ = isEnabled; };
+		void SetRenderPath(RenderPath path) { m_RenderPath = path; };
+		void SetCullMode(CullMode mode) { m_CullMode = mode; };
+		void SetTextureFilter(TextureFilter filter) { m_TextureFilter = filter; };
+		void SetFastMath(bool isEnabled) { m_UseFastMath = isEnabled; };
+		void SetPackedMaterial(bool isEnabled) { m_UsePackedMaterial = isEnabled && m_pMaterialTexture; };
+		void SetTextureLayout(TextureLayout layout);
+		void SetMeshWorldMatrix(const Matrix& worldMatrix) { m_Mesh.worldMatrix = worldMatrix; };
 
-		enum class ShadingMode
-		{
-			ObservedArea,
-			Diffuse,
-			Specular,
-			Combined
-		};
+		//False when Initialize failed and the renderer can't draw anything, the reason is printed
+		bool IsInitialized() const { return m_IsInitialized; };
+
+		//Heap allocations made during the last call to Render, 0 once the renderer is warmed up
+		uint64_t GetLastFrameAllocationCount() const { return m_LastFrameAllocationCount; };
+
+		//Triangles that survived setup during the last call to Render and went on to the rasterizer
+		int GetLastFrameTriangleCount() const { return m_TriangleCount; };
+
+		void PrintShadingMode();
+		void PrintMesh();
+		void PrintRasterizerMode();
+		void PrintTraversalOrder();
+		void PrintMultithreading();
+		void PrintHiZ();
+		void PrintRenderPath();
+		void PrintTextureFilter();
+		void PrintPackedMaterial();
+		void PrintFastMath();
+		void PrintCullMode();
 
 	private:
+		//nullptr when headless
 		SDL_Window* m_pWindow{};
 
 		SDL_Surface* m_pFrontBuffer{ nullptr };
@@ -59,7 +154,21 @@ namespace dae
 
 		Mesh m_Mesh{};
 
+		//The one of the test quads and the vehicle that isn't shown, see ToggleMesh
+		Mesh m_InactiveMesh{};
+
+		//Mapped mesh file m_Mesh renders from in place, kept open for as long as the renderer lives
+		MeshFile* m_pMeshFile{ nullptr };
+
 		float* m_pDepthBufferPixels{};
+		bool m_OwnsDepthBuffer{ false };
+		GBufferTexel* m_pGBuffer{};
+
+		//Coarse depth buffer holding the farthest depth of every block of the depth buffer
+		const int m_HiZBlockSize{ 8 };
+		int m_HiZWidth{};
+		int m_HiZHeight{};
+		float* m_pHiZBuffer{};
 
 		Camera m_Camera{};
 
@@ -72,40 +181,215 @@ namespace dae
 		bool m_RenderFinalColor{ true };
 		bool m_RotationEnabled{ true };
 		bool m_UseNormalMap{ true };
+		bool m_UseMultithreading{ true };
+		bool m_UseHiZ{ true };
+		bool m_UseFastMath{ false };
 		ShadingMode m_ShadingMode{ ShadingMode::Combined };
+		RenderPath m_RenderPath{ RenderPath::Forward };
+		CullMode m_CullMode{ CullMode::Back };
+		TextureFilter m_TextureFilter{ TextureFilter::Trilinear };
+		RasterizerMode m_RasterizerMode{ RasterizerMode::Simd };
+		CoverageDepthKernel m_CoverageDepthKernel{ &RasterKernels::CoverageDepthScalar };
+		VertexTransformKernel m_VertexTransformKernel{ &VertexKernels::TransformScalar };
+		TraversalOrder m_TraversalOrder{ TraversalOrder::RowMajor };
+		const int m_TraversalBlockSize{ 8 };
+
+		ThreadPool* m_pThreadPool{ nullptr };
+
+		//Vertices per vertex stage job, a multiple of 8 so only the last chunk ends in a partial SIMD batch
+		const int m_VertexChunkSize{ 4096 };
+
+		//Scratch memory of the current frame
+		FrameArena* m_pFrameArena{ nullptr };
+		uint64_t m_LastFrameAllocationCount{};
+		int m_WarmUpFrameCount{ 1 };
+
+		//Triangles that survived setup this frame, allocated from the frame arena
+		Triangle* m_pTriangles{ nullptr };
+		int m_TriangleCount{};
+
+		//Screen is split in tiles, every tile keeps the indices of the triangles overlapping it in submission order
+		//Bin i holds m_pTileBinTriangles[m_pTileBinOffsets[i]] up to m_pTileBinTriangles[m_pTileBinOffsets[i + 1]]
+		const int m_TileSize{ 64 };
+		int m_TileCountX{};
+		int m_TileCountY{};
+		int m_TileCount{};
+		int* m_pTileBinOffsets{ nullptr };
+		int* m_pTileBinTriangles{ nullptr };
+
+		//Pixels past every screen edge triangles may reach before they get clipped in x and y,
+		//everything within is left to the rasterizer which only visits the on screen part
+		//As wide as the fixed point edge functions allow, see GetMaxFixedPointExtent
+		int m_GuardBandSize{};
+		Vector2 m_GuardBand{}; //in ndc
+
+		//Fractional bits of the fixed point screen positions, fewer on screens too large for 28.4
+		int m_SubpixelBits{ MaxSubpixelBits };
+
+		//False when the screen is too large even for one fractional bit or the diffuse texture is missing,
+		//Render then leaves the buffers untouched
+		bool m_IsInitialized{ true };
 
 		Texture* m_pDiffuseTexture{ nullptr };
 		Texture* m_pGlossTexture{ nullptr };
 		Texture* m_pSpecularTexture{ nullptr };
 		Texture* m_pNormalMap{ nullptr };
 
+		//The four maps above interleaved, shading reads this one instead when enabled
+		MaterialTexture* m_pMaterialTexture{ nullptr };
+		bool m_UsePackedMaterial{ true };
+
 		const Vector3 m_LightDirection = Vector3{ .577f, -.577f, .577f }.Normalized();
 		float m_LightIntensity{ 7.f };
 		float m_Shininess{ 25.f };
 		ColorRGB m_Ambient{.025f, .025f, .025f};
 
+		//Every option the per pixel work depends on, the rasterizers and shaders get compiled once per combination
+		//so none of them is checked inside a pixel loop
+		struct ShaderPermutation
+		{
+			ShadingMode shadingMode{};
+			bool useNormalMap{};
+			bool renderFinalColor{};
+			bool deferred{};
+			bool renderBoundingBox{};
+			bool useFastMath{};
+
+			static constexpr int Count{ 128 };
+
+			static constexpr ShaderPermutation FromIndex(int index)
+			{
+				return { static_cast<ShadingMode>(index % 4), (index & 4) != 0, (index & 8) != 0, (index & 16) != 0, (index & 32) != 0, (index & 64) != 0 };
+			}
+
+			constexpr int ToIndex() const
+			{
+				return int(shadingMode) | (useNormalMap << 2) | (renderFinalColor << 3) | (deferred << 4) | (renderBoundingBox << 5) | (useFastMath << 6);
+			}
+
+			//Options a pass doesn't look at are cleared, so permutations that only differ in those share one instantiation
+			constexpr ShaderPermutation ForRasterizer() const
+			{
+				if (renderBoundingBox)
+					return { {}, false, false, false, true, false };
+				if (deferred || !renderFinalColor)
+					return { {}, false, renderFinalColor, deferred, false, renderFinalColor && useFastMath };
+				return { shadingMode, useNormalMap, true, false, false, useFastMath };
+			}
+
+			constexpr ShaderPermutation ForResolve() const
+			{
+				if (!renderFinalColor)
+					return {};
+				return { shadingMode, useNormalMap, true, true, false, useFastMath };
+			}
+		};
+
+		//Instantiations of a single permutation, selected once per frame
+		struct PermutationFunctions
+		{
+			void (Renderer::* renderMeshTriangle)(const Mesh& mesh, const Vector2* vertices_ScreenSpace, int startIdx, bool flipTriangle);
+			void (Renderer::* renderTriangle)(const Triangle& triangle, const Tile& tile);
+			void (Renderer::* resolveRows)(int minY, int maxY);
+		};
+
+		const PermutationFunctions* m_pPermutation{ nullptr };
+
+		//Everything both constructors share once the color and depth buffers exist
+		void Initialize();
 		void InitializeMesh();
 
+		//Grows the frame arena to what a frame of m_Mesh takes without clipping, so its first frames don't overflow
+		void ReserveFrameArena();
+
 		//function that returns the bounding box for a triangle
 		BoundingBox GetBoundingBox(Vector2 v0, Vector2 v1, Vector2 v2);
 
 		//function that renders a single mesh
 		void RenderMesh(Mesh& mesh);
+		bool IsOutsideFrustum(const Mesh& mesh) const;
+
+		//function that points m_pPermutation at the instantiations matching the current options
+		void SelectPermutation();
 
 		//function that renders a single triangle
-		void RenderTriangle(const Mesh& mesh, std::vector<Vector2>& vertices_ScreenSpace, int startIdx, bool flipTriangle = false);
+		template<ShaderPermutation permutation>
+		void RenderTriangle(const Mesh& mesh, const Vector2* vertices_ScreenSpace, int startIdx, bool flipTriangle);
+
+		//function that renders the part of a triangle that lies within the given tile
+		template<ShaderPermutation permutation>
+		void RenderTriangle(const Triangle& triangle, const Tile& tile);
+
+		//function that runs the selected rasterizer over an area of the screen, returns if any depth got written
+		template<ShaderPermutation permutation>
+		bool RasterizeArea(const Triangle& triangle, const Tile& area);
+
+		//function that recalculates the farthest depth of a block after it got rasterized to
+		void UpdateHiZ(int blockX, int blockY);
+
+		//function that tests every pixel of the area against the edges from scratch
+		template<ShaderPermutation permutation>
+		bool RasterizePerPixel(const Triangle& triangle, const Tile& area);
+
+		//function that sets the edge equations up once and steps them per pixel and per row
+		template<ShaderPermutation permutation>
+		bool RasterizeIncremental(const Triangle& triangle, const Tile& area);
+
+		//function that runs coverage and depth of a row in blocks through the selected simd kernel
+		template<ShaderPermutation permutation>
+		bool RasterizeSimd(const Triangle& triangle, const Tile& area);
+
+		//function that depth tests, interpolates and shades a single covered pixel, returns if it passed the depth test
+		template<ShaderPermutation permutation>
+		bool ShadePixel(const Triangle& triangle, int px, int py, float weightV0, float weightV1, float weightV2);
 
-		void RenderTriangle(const Triangle& triangle);
+		//function that interpolates and shades a pixel that already passed the depth test, or stores it in the G-buffer
+		template<ShaderPermutation permutation>
+		void ShadeFragment(const Triangle& triangle, int px, int py, float weightV0, float weightV1, float weightV2, float interpolatedZDepth);
 
-		//function to setup current triangle
-		bool CalculateTriangle(Triangle& triangle,const Mesh& mesh, std::vector<Vector2>& vertices_ScreenSpace, int startIdx, bool flipTriangle = false);
+		//function that interpolates the vertex attributes perspective correctly
+		template<ShaderPermutation permutation>
+		Pixel_Out InterpolatePixel(const Triangle& triangle, int px, int py, float weightV0, float weightV1, float weightV2, float interpolatedZDepth) const;
+
+		//function that writes a color to the back buffer
+		void WritePixel(int pixelIdx, ColorRGB finalColor);
+
+		//function that shades every pixel covered this frame from the G-buffer
+		void ResolveGBuffer();
+
+		//function that shades the covered pixels of a band of rows from the G-buffer
+		template<ShaderPermutation permutation>
+		void ResolveRows(int minY, int maxY);
+
+		//function that sets up all triangles of a mesh into m_pTriangles
+		void GatherTriangles(const Mesh& mesh, const Vector2* vertices_ScreenSpace, const uint16_t* pClipCodes);
+
+		//function that sorts the gathered triangles into the tiles they overlap
+		void BinTriangles();
+
+		//function that renders every binned triangle of a single tile
+		void RenderTile(int tileIdx);
+
+		//function that sets up the bounding box and gradients of a triangle whose vertices are filled in
+		//returns false when the triangle is culled or can't cover a single pixel
+		bool SetupTriangle(Triangle& triangle);
+
+		//function that clips a triangle against the crossed planes and sets up the pieces in pTriangles, returns how many there are
+		int ClipTriangle(Triangle* pTriangles, const Mesh& mesh, const Matrix& worldViewProjection, const uint32_t* pIndices, uint16_t crossedPlanes);
 
 		//Function that transforms the vertices from the mesh from World space to Screen space
-		void VertexTransformationFunction(Mesh& mesh) const; //W1 Version
+		//Transforms the mesh into vertices_out and projects it into vertices_ScreenSpace, chunk by chunk on the thread pool
+		//pClipCodes receives the planes every vertex lies outside of
+		void VertexTransformationFunction(Mesh& mesh, Vector2* vertices_ScreenSpace, uint16_t* pClipCodes) const; //W1 Version
 
 		//Function that shades a single pixel
+		template<ShaderPermutation permutation>
 		ColorRGB PixelShading(Pixel_Out& pixel);
 
-		ColorRGB CalculateSpecular(const Pixel_Out& pixel, const Vector3& sampeledNormal);
+		template<ShaderPermutation permutation>
+		ColorRGB CalculateSpecular(const Pixel_Out& pixel, const Vector3& sampeledNormal, const MaterialSample& material);
+
+		//Reads every material map at the pixel, from the packed material or the separate textures
+		MaterialSample SampleMaterial(const Pixel_Out& pixel) const;
 	};
 }
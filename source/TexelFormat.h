@@ -0,0 +1,45 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include "ColorRGB.h"
+
+namespace dae
+{
+	//RGBA8 texels the textures store, r in the lowest byte and a in the highest
+	namespace TexelFormat
+	{
+		//channel / 255.0f for every channel value, so decoding a texel is three lookups
+		inline const std::array<float, 256> ChannelToFloat
+		{
+			[]()
+			{
+				std::array<float, 256> table{};
+				for (int value{}; value < 256; ++value)
+				{
+					table[value] = value / 255.0f;
+				}
+				return table;
+			}()
+		};
+
+		inline uint32_t PackRGBA(uint32_t r, uint32_t g, uint32_t b, uint32_t a)
+		{
+			return r | (g << 8) | (b << 16) | (a << 24);
+		}
+
+		//Texels of the material maps a mesh doesn't have, no gloss, no specular and a normal straight out of the surface
+		inline const uint32_t FlatGloss{ PackRGBA(0, 0, 0, 255) };
+		inline const uint32_t FlatSpecular{ PackRGBA(0, 0, 0, 255) };
+		inline const uint32_t FlatNormal{ PackRGBA(128, 128, 255, 255) };
+
+		inline ColorRGB UnpackRGB(uint32_t texel)
+		{
+			return ColorRGB{ ChannelToFloat[texel & 0xFF], ChannelToFloat[(texel >> 8) & 0xFF], ChannelToFloat[(texel >> 16) & 0xFF] };
+		}
+
+		inline float UnpackA(uint32_t texel)
+		{
+			return ChannelToFloat[texel >> 24];
+		}
+	}
+}
@@ -1,55 +1,264 @@
 #include "Texture.h"
+#include "TexelFormat.h"
 #include "Vector2.h"
 #include <SDL_image.h>
+#include <algorithm>
+#include <cmath>
 #include <iostream>
 
 namespace dae
 {
-	Texture::Texture(SDL_Surface* pSurface) :
-		m_pSurface{ pSurface },
-		m_pSurfacePixels{ (uint32_t*)pSurface->pixels }
+	Texture::Texture(SDL_Surface* pSurface)
 	{
+		//The surface is only needed to decode from, sampling never touches it
+		BuildMipChain(pSurface);
+		SDL_FreeSurface(pSurface);
 	}
 
-	Texture::~Texture()
+	Texture::~Texture() = default;
+
+	Texture* Texture::LoadFromFile(const std::string& path, TextureLayout layout)
 	{
-		if (m_pSurface)
+		SDL_Surface* pLoadedSurface{ IMG_Load(path.c_str()) };
+		if (!pLoadedSurface)
 		{
-			SDL_FreeSurface(m_pSurface);
-			m_pSurface = nullptr;
+			std::cout << "Can't load texture " << path << ": " << IMG_GetError() << "\n";
+			return nullptr;
 		}
+
+		//Images come in any bit depth or channel order, converting them up front lets the mip chain read every texel the same way
+		SDL_Surface* pSurface{ SDL_ConvertSurfaceFormat(pLoadedSurface, SDL_PIXELFORMAT_RGBA32, 0) };
+		SDL_FreeSurface(pLoadedSurface);
+		if (!pSurface)
+		{
+			std::cout << "Can't convert texture " << path << " to RGBA: " << SDL_GetError() << "\n";
+			return nullptr;
+		}
+
+		Texture* pTexture{ new Texture{ pSurface } };
+		pTexture->SetLayout(layout);
+
+		return pTexture;
 	}
 
-	Texture* Texture::LoadFromFile(const std::string& path)
+	ColorRGB Texture::Sample(const Vector2& uv) const
 	{
-		//TODO
-		//Load SDL_Surface using IMG_LOAD
-		//Create & Return a new Texture Object (using SDL_Surface)
+		const MipLevel& baseLevel{ m_MipLevels[0] };
 
-		return new Texture{ IMG_Load(path.c_str()) };
+		//calculate the x and y coordinates on the uv map, uv 1 would land one texel past the edge
+		const int x{ Clamp(static_cast<int>(uv.x * baseLevel.width), 0, baseLevel.width - 1) };
+		const int y{ Clamp(static_cast<int>(uv.y * baseLevel.height), 0, baseLevel.height - 1) };
+
+		//get the color of the texel, in [0, 1] range
+		return Fetch(baseLevel, x, y);
 	}
 
-	ColorRGB Texture::Sample(const Vector2& uv) const
+	ColorRGB Texture::Sample(const Vector2& uv, const Vector2& uvDdx, const Vector2& uvDdy, TextureFilter filter) const
+	{
+		switch (filter)
+		{
+		case TextureFilter::Bilinear:
+		{
+			const int level{ static_cast<int>(std::lround(CalculateMipLevel(uvDdx, uvDdy, m_MipLevels[0].width, m_MipLevels[0].height, GetMipLevelCount()))) };
+			return SampleBilinear(m_MipLevels[level], uv);
+		}
+		case TextureFilter::Trilinear:
+		{
+			const float level{ CalculateMipLevel(uvDdx, uvDdy, m_MipLevels[0].width, m_MipLevels[0].height, GetMipLevelCount()) };
+			const int finerLevel{ static_cast<int>(level) };
+			const int coarserLevel{ std::min(finerLevel + 1, GetMipLevelCount() - 1) };
+
+			const ColorRGB finerColor{ SampleBilinear(m_MipLevels[finerLevel], uv) };
+			if (coarserLevel == finerLevel)
+				return finerColor;
+
+			return ColorRGB::Lerp(finerColor, SampleBilinear(m_MipLevels[coarserLevel], uv), level - finerLevel);
+		}
+		case TextureFilter::Point:
+		default:
+			return Sample(uv);
+		}
+	}
+
+	void Texture::BuildMipChain(SDL_Surface* pSurface)
+	{
+		//RGBA32 holds r, g, b and a in that byte order on every platform, the surface pitch can be wider than a row
+		MipLevel baseLevel{ pSurface->w, pSurface->h };
+		AllocateTexels(baseLevel, static_cast<size_t>(baseLevel.width) * baseLevel.height);
+
+		for (int y{}; y < baseLevel.height; ++y)
+		{
+			const uint8_t* pRow{ static_cast<const uint8_t*>(pSurface->pixels) + y * pSurface->pitch };
+
+			for (int x{}; x < baseLevel.width; ++x)
+			{
+				const uint8_t* pTexel{ pRow + 4 * x };
+				baseLevel.pTexels[x + static_cast<size_t>(y) * baseLevel.width] = TexelFormat::PackRGBA(pTexel[0], pTexel[1], pTexel[2], pTexel[3]);
+			}
+		}
+
+		m_MipLevels.push_back(std::move(baseLevel));
+
+		//Every level averages 2x2 texels of the previous one, odd sizes repeat their last row or column
+		while (m_MipLevels.back().width > 1 || m_MipLevels.back().height > 1)
+		{
+			const MipLevel& previous{ m_MipLevels.back() };
+
+			MipLevel level{ std::max(previous.width / 2, 1), std::max(previous.height / 2, 1) };
+			AllocateTexels(level, static_cast<size_t>(level.width) * level.height);
+
+			for (int y{}; y < level.height; ++y)
+			{
+				for (int x{}; x < level.width; ++x)
+				{
+					const int x0{ 2 * x };
+					const int y0{ 2 * y };
+					const int x1{ std::min(x0 + 1, previous.width - 1) };
+					const int y1{ std::min(y0 + 1, previous.height - 1) };
+
+					const uint32_t texels[4]
+					{
+						previous.pTexels[x0 + y0 * previous.width],
+						previous.pTexels[x1 + y0 * previous.width],
+						previous.pTexels[x0 + y1 * previous.width],
+						previous.pTexels[x1 + y1 * previous.width]
+					};
+
+					uint32_t sumR{};
+					uint32_t sumG{};
+					uint32_t sumB{};
+					uint32_t sumA{};
+
+					for (const uint32_t texel : texels)
+					{
+						sumR += texel & 0xFF;
+						sumG += (texel >> 8) & 0xFF;
+						sumB += (texel >> 16) & 0xFF;
+						sumA += texel >> 24;
+					}
+
+					//+ 2 rounds to the nearest value instead of down
+					level.pTexels[x + y * level.width] = TexelFormat::PackRGBA((sumR + 2) / 4, (sumG + 2) / 4, (sumB + 2) / 4, (sumA + 2) / 4);
+				}
+			}
+
+			m_MipLevels.push_back(std::move(level));
+		}
+	}
+
+	void Texture::SetLayout(TextureLayout layout)
+	{
+		if (layout == m_Layout)
+			return;
+
+		for (MipLevel& level : m_MipLevels)
+		{
+			MipLevel rearranged{ level.width, level.height };
+
+			if (layout == TextureLayout::Tiled)
+			{
+				//Partial tiles at the right and bottom edge are padded, those texels are never read
+				rearranged.tileCountX = (level.width + TileSize - 1) / TileSize;
+				const int tileCountY{ (level.height + TileSize - 1) / TileSize };
+				AllocateTexels(rearranged, static_cast<size_t>(rearranged.tileCountX) * tileCountY * TileSize * TileSize);
+			}
+			else
+			{
+				AllocateTexels(rearranged, static_cast<size_t>(level.width) * level.height);
+			}
+
+			for (int y{}; y < level.height; ++y)
+			{
+				for (int x{}; x < level.width; ++x)
+				{
+					rearranged.pTexels[GetTexelIndex(rearranged, layout, x, y)] = level.pTexels[GetTexelIndex(level, m_Layout, x, y)];
+				}
+			}
+
+			level = std::move(rearranged);
+		}
+
+		m_Layout = layout;
+	}
+
+	void Texture::AllocateTexels(MipLevel& level, size_t texelCount)
+	{
+		//Over allocate by a cache line so a tile never straddles two of them
+		level.storage.resize(texelCount + CacheLineTexelCount - 1);
+
+		const uintptr_t address{ reinterpret_cast<uintptr_t>(level.storage.data()) };
+		const uintptr_t alignedAddress{ (address + 63) & ~uintptr_t(63) };
+
+		level.pTexels = level.storage.data() + (alignedAddress - address) / sizeof(uint32_t);
+	}
+
+	size_t Texture::GetTexelIndex(const MipLevel& level, TextureLayout layout, int x, int y)
+	{
+		if (layout == TextureLayout::Linear)
+			return x + static_cast<size_t>(y) * level.width;
+
+		//Coordinates are never negative, unsigned keeps the divisions and modulos plain shifts and masks
+		const unsigned int tileX{ static_cast<unsigned int>(x) / TileSize };
+		const unsigned int tileY{ static_cast<unsigned int>(y) / TileSize };
+		const unsigned int texelInTile{ (static_cast<unsigned int>(y) % TileSize) * TileSize + static_cast<unsigned int>(x) % TileSize };
+
+		return (tileX + static_cast<size_t>(tileY) * level.tileCountX) * TileSize * TileSize + texelInTile;
+	}
+
+	float Texture::CalculateMipLevel(const Vector2& uvDdx, const Vector2& uvDdy, int baseWidth, int baseHeight, int mipLevelCount)
 	{
-		//TODO
-		//Sample the correct texel for the given uv
+		//Footprint of the pixel in base level texels, along its longest screen axis
+		const float width{ static_cast<float>(baseWidth) };
+		const float height{ static_cast<float>(baseHeight) };
+
+		const float lengthSquaredX{ Square(uvDdx.x * width) + Square(uvDdx.y * height) };
+		const float lengthSquaredY{ Square(uvDdy.x * width) + Square(uvDdy.y * height) };
+
+		const float lengthSquared{ std::max(lengthSquaredX, lengthSquaredY) };
+		if (!(lengthSquared > 1.f))
+			return 0.f;
+
+		//log2 of the length, without the square root
+		const float level{ 0.5f * std::log2(lengthSquared) };
+
+		return std::min(level, static_cast<float>(mipLevelCount - 1));
+	}
 
-		//calculate the x and y coordinates on the uv map
-		const int x{ static_cast<int>(uv.x * m_pSurface->w) };
-		const int y{ static_cast<int>(uv.y * m_pSurface->h) };
+	uint32_t Texture::GetTexel(int level, int x, int y) const
+	{
+		const MipLevel& mipLevel{ m_MipLevels[level] };
+		return mipLevel.pTexels[GetTexelIndex(mipLevel, m_Layout, x, y)];
+	}
 
+	ColorRGB Texture::Fetch(const MipLevel& level, int x, int y) const
+	{
 		//getht the index of the pixel in the list
-		const uint32_t pixel{m_pSurfacePixels[x + y * m_pSurface->w]};
+		const uint32_t pixel{ level.pTexels[GetTexelIndex(level, m_Layout, x, y)] };
+
+		//return the channels in [0, 1] range
+		return TexelFormat::UnpackRGB(pixel);
+	}
+
+	ColorRGB Texture::SampleBilinear(const MipLevel& level, const Vector2& uv) const
+	{
+		//Texel centers sit at half texel offsets, clamp to the edge outside of them
+		const float x{ uv.x * level.width - 0.5f };
+		const float y{ uv.y * level.height - 0.5f };
+
+		const float floorX{ std::floor(x) };
+		const float floorY{ std::floor(y) };
+
+		const float fractionX{ x - floorX };
+		const float fractionY{ y - floorY };
 
-		//initialize the rgb values in the [0, 255] range
-		Uint8 r{};
-		Uint8 g{};
-		Uint8 b{};
+		const int x0{ Clamp(static_cast<int>(floorX), 0, level.width - 1) };
+		const int y0{ Clamp(static_cast<int>(floorY), 0, level.height - 1) };
+		const int x1{ Clamp(static_cast<int>(floorX) + 1, 0, level.width - 1) };
+		const int y1{ Clamp(static_cast<int>(floorY) + 1, 0, level.height - 1) };
 
-		//Get correct values from the texture
-		SDL_GetRGB(pixel, m_pSurface->format, &r, &g, &b);
+		const ColorRGB top{ ColorRGB::Lerp(Fetch(level, x0, y0), Fetch(level, x1, y0), fractionX) };
+		const ColorRGB bottom{ ColorRGB::Lerp(Fetch(level, x0, y1), Fetch(level, x1, y1), fractionX) };
 
-		//return color divided by 255 to get colors in [0, 1] range
-		return ColorRGB{r/255.0f, g/255.0f, b/255.0f};
+		return ColorRGB::Lerp(top, bottom, fractionY);
 	}
-}
\ No newline at end of file
+}
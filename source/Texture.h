@@ -1,24 +1,93 @@
 #pragma once
-#include <SDL_surface.h>
+#include <cstdint>
 #include <string>
+#include <vector>
 #include "ColorRGB.h"
 
+struct SDL_Surface;
+
 namespace dae
 {
 	struct Vector2;
 
+	//Point only reads the base level, bilinear filters the closest mip level and trilinear blends the two closest ones
+	enum class TextureFilter
+	{
+		Point,
+		Bilinear,
+		Trilinear
+	};
+
+	//Linear stores texels row after row, tiled stores tiles of one cache line each, tile row after tile row
+	//so a bilinear footprint or a diagonal walk over the texture stays within few cache lines
+	//A tile holds 4x4 texels of a Texture and 2x2 of the four times larger MaterialTexture texels
+	enum class TextureLayout
+	{
+		Linear,
+		Tiled
+	};
+
 	class Texture
 	{
 	public:
 		~Texture();
 
-		static Texture* LoadFromFile(const std::string& path);
+		Texture(const Texture&) = delete;
+		Texture(Texture&&) noexcept = delete;
+		Texture& operator=(const Texture&) = delete;
+		Texture& operator=(Texture&&) noexcept = delete;
+
+		//Decodes the image once into RGBA8 and builds the full mip chain down to 1x1
+		//Returns nullptr when the image can't be loaded
+		static Texture* LoadFromFile(const std::string& path, TextureLayout layout = TextureLayout::Linear);
+
+		//Nearest texel of the base level
 		ColorRGB Sample(const Vector2& uv) const;
 
+		//uvDdx and uvDdy are how much the uv changes per pixel in screen x and y, they pick the mip level
+		ColorRGB Sample(const Vector2& uv, const Vector2& uvDdx, const Vector2& uvDdy, TextureFilter filter) const;
+
+		int GetMipLevelCount() const { return static_cast<int>(m_MipLevels.size()); };
+		int GetWidth(int level = 0) const { return m_MipLevels[level].width; };
+		int GetHeight(int level = 0) const { return m_MipLevels[level].height; };
+
+		//Raw RGBA8 texel, see TexelFormat
+		uint32_t GetTexel(int level, int x, int y) const;
+
+		//Mip level, with fraction, whose texels best match the footprint of a pixel with these uv derivatives
+		static float CalculateMipLevel(const Vector2& uvDdx, const Vector2& uvDdy, int baseWidth, int baseHeight, int mipLevelCount);
+
+		//Rearranges the texels of every level, sampling gives the same result in both layouts
+		void SetLayout(TextureLayout layout);
+		TextureLayout GetLayout() const { return m_Layout; };
+
 	private:
 		Texture(SDL_Surface* pSurface);
 
-		SDL_Surface* m_pSurface{ nullptr };
-		uint32_t* m_pSurfacePixels{ nullptr };
+		//Texels are RGBA8 in a fixed order whatever format the image had, r in the lowest byte and a in the highest
+		struct MipLevel
+		{
+			int width{};
+			int height{};
+			int tileCountX{}; //tiles per tile row, tiled layout only
+
+			std::vector<uint32_t> storage{};
+			uint32_t* pTexels{ nullptr }; //first cache line aligned texel of storage
+		};
+
+		static constexpr int TileSize{ 4 };
+		static constexpr size_t CacheLineTexelCount{ 64 / sizeof(uint32_t) };
+
+		static void AllocateTexels(MipLevel& level, size_t texelCount);
+
+		//pSurface has to be SDL_PIXELFORMAT_RGBA32
+		void BuildMipChain(SDL_Surface* pSurface);
+
+		static size_t GetTexelIndex(const MipLevel& level, TextureLayout layout, int x, int y);
+		ColorRGB Fetch(const MipLevel& level, int x, int y) const;
+		ColorRGB SampleBilinear(const MipLevel& level, const Vector2& uv) const;
+
+		std::vector<MipLevel> m_MipLevels{};
+		TextureLayout m_Layout{ TextureLayout::Linear };
 	};
-}
\ No newline at end of file
+}
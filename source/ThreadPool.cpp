@@ -0,0 +1,99 @@
+#include "ThreadPool.h"
+
+using namespace dae;
+
+ThreadPool::ThreadPool(unsigned int threadCount)
+{
+	//hardware_concurrency is allowed to return 0, the calling thread always works along
+	const unsigned int workerCount{ threadCount > 1 ? threadCount - 1 : 0 };
+
+	m_Workers.reserve(workerCount);
+	for (unsigned int i{}; i < workerCount; ++i)
+	{
+		m_Workers.emplace_back(&ThreadPool::WorkerLoop, this);
+	}
+}
+
+ThreadPool::~ThreadPool()
+{
+	{
+		std::lock_guard<std::mutex> lock{ m_Mutex };
+		m_IsStopping = true;
+	}
+	m_WakeCondition.notify_all();
+
+	for (auto& worker : m_Workers)
+	{
+		worker.join();
+	}
+}
+
+void ThreadPool::ParallelFor(int jobCount, const std::function<void(int)>& job)
+{
+	if (jobCount <= 0)
+		return;
+
+	//Not worth waking anyone up for
+	if (m_Workers.empty() || jobCount == 1)
+	{
+		for (int i{}; i < jobCount; ++i)
+		{
+			job(i);
+		}
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock{ m_Mutex };
+		m_pJob = &job;
+		m_JobCount = jobCount;
+		m_NextJob.store(0);
+		m_BusyWorkers = static_cast<int>(m_Workers.size());
+		++m_Generation;
+	}
+	m_WakeCondition.notify_all();
+
+	RunJobs();
+
+	//Every worker has to check in before the job may go out of scope
+	std::unique_lock<std::mutex> lock{ m_Mutex };
+	m_DoneCondition.wait(lock, [this]() { return m_BusyWorkers == 0; });
+	m_pJob = nullptr;
+}
+
+void ThreadPool::WorkerLoop()
+{
+	uint64_t lastGeneration{};
+
+	while (true)
+	{
+		{
+			std::unique_lock<std::mutex> lock{ m_Mutex };
+			m_WakeCondition.wait(lock, [&]() { return m_IsStopping || m_Generation != lastGeneration; });
+
+			if (m_IsStopping)
+				return;
+
+			lastGeneration = m_Generation;
+		}
+
+		RunJobs();
+
+		bool isLastWorker{};
+		{
+			std::lock_guard<std::mutex> lock{ m_Mutex };
+			isLastWorker = --m_BusyWorkers == 0;
+		}
+
+		if (isLastWorker)
+			m_DoneCondition.notify_one();
+	}
+}
+
+void ThreadPool::RunJobs()
+{
+	for (int jobIdx{ m_NextJob.fetch_add(1) }; jobIdx < m_JobCount; jobIdx = m_NextJob.fetch_add(1))
+	{
+		(*m_pJob)(jobIdx);
+	}
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+//Standard includes
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace dae
+{
+	class ThreadPool final
+	{
+	public:
+		//threadCount includes the calling thread, so threadCount - 1 workers get spawned
+		explicit ThreadPool(unsigned int threadCount = std::thread::hardware_concurrency());
+		~ThreadPool();
+
+		ThreadPool(const ThreadPool&) = delete;
+		ThreadPool(ThreadPool&&) noexcept = delete;
+		ThreadPool& operator=(const ThreadPool&) = delete;
+		ThreadPool& operator=(ThreadPool&&) noexcept = delete;
+
+		//Runs job(i) for every i in [0, jobCount) on the workers and the calling thread
+		//Returns once every job has finished
+		void ParallelFor(int jobCount, const std::function<void(int)>& job);
+
+		unsigned int GetThreadCount() const { return static_cast<unsigned int>(m_Workers.size()) + 1; };
+
+	private:
+		std::vector<std::thread> m_Workers{};
+
+		std::mutex m_Mutex{};
+		std::condition_variable m_WakeCondition{};
+		std::condition_variable m_DoneCondition{};
+
+		const std::function<void(int)>* m_pJob{ nullptr };
+		int m_JobCount{};
+		std::atomic<int> m_NextJob{};
+
+		int m_BusyWorkers{};
+		uint64_t m_Generation{};
+		bool m_IsStopping{ false };
+
+		void WorkerLoop();
+
+		//Keeps grabbing job indices until all jobs of the current generation are taken
+		void RunJobs();
+	};
+}
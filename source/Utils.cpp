@@ -0,0 +1,891 @@
+#include "Utils.h"
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <charconv>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <string_view>
+
+namespace dae
+{
+	namespace
+	{
+		bool IsSpace(char character)
+		{
+			return character == ' ' || character == '\t';
+		}
+
+		const char* SkipSpaces(const char* pText, const char* pEnd)
+		{
+			while (pText < pEnd && IsSpace(*pText))
+				++pText;
+
+			return pText;
+		}
+
+		const char* SkipLine(const char* pText, const char* pEnd)
+		{
+			const void* pNewline{ std::memchr(pText, '\n', pEnd - pText) };
+			return pNewline ? static_cast<const char*>(pNewline) + 1 : pEnd;
+		}
+
+		bool IsLineEnd(const char* pText, const char* pEnd)
+		{
+			return pText == pEnd || *pText == '\n' || *pText == '\r';
+		}
+
+		//True when the line at pText is a record of this type, the keyword followed by a space
+		bool IsRecord(const char* pText, const char* pEnd, std::string_view keyword)
+		{
+			return static_cast<size_t>(pEnd - pText) > keyword.size()
+				&& std::equal(keyword.begin(), keyword.end(), pText)
+				&& IsSpace(pText[keyword.size()]);
+		}
+
+		//Skips the spaces in front of the number and leaves pText right behind it
+		template<typename T>
+		bool ParseNumber(const char*& pText, const char* pEnd, T& value)
+		{
+			pText = SkipSpaces(pText, pEnd);
+
+			//from_chars doesn't take the plus sign some exporters write
+			if (pText < pEnd && *pText == '+')
+				++pText;
+
+			const auto [pNumberEnd, error] { std::from_chars(pText, pEnd, value) };
+			if (error != std::errc{})
+				return false;
+
+			pText = pNumberEnd;
+			return true;
+		}
+
+		//Obj indices are 1 based, negative ones count back from the last element read so far
+		bool ParseIndex(const char*& pText, const char* pEnd, size_t count, uint32_t& index)
+		{
+			int objIndex{};
+			if (!ParseNumber(pText, pEnd, objIndex))
+				return false;
+
+			if (objIndex > 0 && static_cast<size_t>(objIndex) <= count)
+				index = static_cast<uint32_t>(objIndex - 1);
+			else if (objIndex < 0 && static_cast<size_t>(-objIndex) <= count)
+				index = static_cast<uint32_t>(count + objIndex);
+			else
+				return false;
+
+			return true;
+		}
+
+		//Open addressing map from the position, uv and normal index of a face corner to the vertex made for it
+		//A flat table instead of std::unordered_map, so inserting doesn't allocate a node per vertex
+		class CornerVertexMap final
+		{
+		public:
+			//Index a corner without a uv or normal uses for it
+			static constexpr uint32_t None{ UINT32_MAX };
+
+			explicit CornerVertexMap(size_t expectedCount)
+			{
+				Resize(std::bit_ceil(std::max(expectedCount * 2, size_t{ 16 })));
+			}
+
+			//Returns the vertex of an earlier identical corner, or stores newVertex for this one and returns that
+			uint32_t FindOrInsert(uint32_t position, uint32_t uv, uint32_t normal, uint32_t newVertex)
+			{
+				//Stay at most half full so probe sequences stay short
+				if (2 * (m_Count + 1) > m_Entries.size())
+					Resize(2 * m_Entries.size());
+
+				for (size_t slot{ Hash(position, uv, normal) & m_Mask }; ; slot = (slot + 1) & m_Mask)
+				{
+					Entry& entry{ m_Entries[slot] };
+
+					if (entry.vertex == None)
+					{
+						entry = { position, uv, normal, newVertex };
+						++m_Count;
+						return newVertex;
+					}
+
+					if (entry.position == position && entry.uv == uv && entry.normal == normal)
+						return entry.vertex;
+				}
+			}
+
+		private:
+			struct Entry
+			{
+				uint32_t position{};
+				uint32_t uv{};
+				uint32_t normal{};
+				uint32_t vertex{ None };
+			};
+
+			std::vector<Entry> m_Entries{};
+			size_t m_Mask{};
+			size_t m_Count{};
+
+			static size_t Hash(uint32_t position, uint32_t uv, uint32_t normal)
+			{
+				uint64_t hash{ position * 0x9E3779B97F4A7C15ull ^ uv * 0xC2B2AE3D27D4EB4Full ^ normal * 0x165667B19E3779F9ull };
+				hash ^= hash >> 29;
+				return static_cast<size_t>(hash);
+			}
+
+			void Resize(size_t capacity)
+			{
+				std::vector<Entry> oldEntries{ std::move(m_Entries) };
+
+				m_Entries.assign(capacity, Entry{});
+				m_Mask = capacity - 1;
+				m_Count = 0;
+
+				for (const Entry& entry : oldEntries)
+				{
+					if (entry.vertex != None)
+						FindOrInsert(entry.position, entry.uv, entry.normal, entry.vertex);
+				}
+			}
+		};
+
+		struct ObjRecordCounts
+		{
+			size_t positionCount{};
+			size_t uvCount{};
+			size_t normalCount{};
+			size_t faceCount{};
+		};
+
+		//Counting the records first lets the output be reserved once instead of growing while parsing
+		ObjRecordCounts CountRecords(const char* pText, const char* pEnd)
+		{
+			ObjRecordCounts counts{};
+
+			while (pText < pEnd)
+			{
+				pText = SkipSpaces(pText, pEnd);
+
+				if (IsRecord(pText, pEnd, "v"))
+					++counts.positionCount;
+				else if (IsRecord(pText, pEnd, "vt"))
+					++counts.uvCount;
+				else if (IsRecord(pText, pEnd, "vn"))
+					++counts.normalCount;
+				else if (IsRecord(pText, pEnd, "f"))
+					++counts.faceCount;
+
+				pText = SkipLine(pText, pEnd);
+			}
+
+			return counts;
+		}
+
+		//Runs the jobs on the pool when there is one, otherwise one after the other on this thread
+		void RunJobs(ThreadPool* pThreadPool, int jobCount, const std::function<void(int)>& job)
+		{
+			if (pThreadPool)
+			{
+				pThreadPool->ParallelFor(jobCount, job);
+				return;
+			}
+
+			for (int i{}; i < jobCount; ++i)
+			{
+				job(i);
+			}
+		}
+
+		//A single job without a pool, otherwise jobsPerThread per thread as long as each gets at least minWorkPerJob
+		int GetJobCount(const ThreadPool* pThreadPool, size_t workCount, size_t minWorkPerJob, int jobsPerThread)
+		{
+			if (!pThreadPool)
+				return 1;
+
+			const size_t maxJobCount{ std::max(workCount / minWorkPerJob, size_t{ 1 }) };
+			return static_cast<int>(std::min(maxJobCount, size_t{ pThreadPool->GetThreadCount() } * jobsPerThread));
+		}
+
+		//First element of the job'th of jobCount equal ranges splitting [0, count)
+		size_t GetRangeBegin(size_t count, int jobCount, int job)
+		{
+			return count * job / jobCount;
+		}
+
+		void CalculateTangents(std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices, bool flipAxisAndWinding, ThreadPool* pThreadPool)
+		{
+			constexpr size_t MinTrianglesPerJob{ 4096 };
+			constexpr size_t MinVerticesPerJob{ 4096 };
+
+			const size_t triangleCount{ indices.size() / 3 };
+			std::vector<Vector3> triangleTangents(triangleCount);
+
+			//Cheap Tangent Calculations
+			const int triangleJobCount{ GetJobCount(pThreadPool, triangleCount, MinTrianglesPerJob, 1) };
+			RunJobs(pThreadPool, triangleJobCount, [&](int job)
+				{
+					const size_t end{ GetRangeBegin(triangleCount, triangleJobCount, job + 1) };
+					for (size_t triangle{ GetRangeBegin(triangleCount, triangleJobCount, job) }; triangle < end; ++triangle)
+					{
+						uint32_t index0 = indices[3 * triangle];
+						uint32_t index1 = indices[3 * triangle + 1];
+						uint32_t index2 = indices[3 * triangle + 2];
+
+						const Vector3& p0 = vertices[index0].position;
+						const Vector3& p1 = vertices[index1].position;
+						const Vector3& p2 = vertices[index2].position;
+						const Vector2& uv0 = vertices[index0].uv;
+						const Vector2& uv1 = vertices[index1].uv;
+						const Vector2& uv2 = vertices[index2].uv;
+
+						const Vector3 edge0 = p1 - p0;
+						const Vector3 edge1 = p2 - p0;
+						const Vector2 diffX = Vector2(uv1.x - uv0.x, uv2.x - uv0.x);
+						const Vector2 diffY = Vector2(uv1.y - uv0.y, uv2.y - uv0.y);
+						float r = 1.f / Vector2::Cross(diffX, diffY);
+
+						triangleTangents[triangle] = (edge0 * diffY.y - edge1 * diffY.x) * r;
+					}
+				});
+
+			//Triangles using each vertex, packed vertex after vertex in ascending triangle order
+			//A triangle using a vertex twice is listed twice, the same as the corners of the serial loop add it twice
+			std::vector<uint32_t> firstVertexTriangles(vertices.size() + 1);
+			for (size_t i{}; i < 3 * triangleCount; ++i)
+			{
+				++firstVertexTriangles[indices[i] + 1];
+			}
+			for (size_t vertex{}; vertex < vertices.size(); ++vertex)
+			{
+				firstVertexTriangles[vertex + 1] += firstVertexTriangles[vertex];
+			}
+
+			std::vector<uint32_t> vertexTriangles(3 * triangleCount);
+			{
+				std::vector<uint32_t> nextSlots(firstVertexTriangles.begin(), firstVertexTriangles.end() - 1);
+				for (size_t i{}; i < 3 * triangleCount; ++i)
+				{
+					vertexTriangles[nextSlots[indices[i]]++] = static_cast<uint32_t>(i / 3);
+				}
+			}
+
+			//Every job owns a range of vertices and only walks their triangles, in triangle order,
+			//no two jobs write the same vertex and the sums come out exactly as a single loop would add them
+			const int vertexJobCount{ GetJobCount(pThreadPool, vertices.size(), MinVerticesPerJob, 1) };
+			RunJobs(pThreadPool, vertexJobCount, [&](int job)
+				{
+					const size_t begin{ GetRangeBegin(vertices.size(), vertexJobCount, job) };
+					const size_t end{ GetRangeBegin(vertices.size(), vertexJobCount, job + 1) };
+
+					for (size_t index{ begin }; index < end; ++index)
+					{
+						Vector3& tangent{ vertices[index].tangent };
+						for (uint32_t i{ firstVertexTriangles[index] }; i < firstVertexTriangles[index + 1]; ++i)
+						{
+							tangent += triangleTangents[vertexTriangles[i]];
+						}
+					}
+
+					//Fix the tangents per vertex now because we accumulated
+					for (size_t index{ begin }; index < end; ++index)
+					{
+						Vertex& v{ vertices[index] };
+						v.tangent = Vector3::Reject(v.tangent, v.normal).Normalized();
+
+						if (flipAxisAndWinding)
+						{
+							v.position.z *= -1.f;
+							v.normal.z *= -1.f;
+							v.tangent.z *= -1.f;
+						}
+					}
+				});
+		}
+
+		//Face corner as the position, uv and normal index it references
+		struct ObjCorner
+		{
+			uint32_t position{};
+			uint32_t uv{};
+			uint32_t normal{};
+		};
+
+		//Line aligned piece of an obj file that gets parsed on its own
+		struct ObjChunk
+		{
+			const char* pBegin{};
+			const char* pEnd{};
+
+			ObjRecordCounts counts{};
+
+			//Records in all chunks before this one, which is where this chunk's positions, uvs and normals go
+			ObjRecordCounts firstRecords{};
+
+			std::vector<ObjCorner> corners{};
+			std::vector<uint32_t> faceCornerCounts{};
+		};
+
+		//Parses the chunk's positions, uvs and normals into their place in the shared arrays and resolves the indices of its faces
+		//An index only sees what is defined above it in the file, the same as when parsing from top to bottom
+		bool ParseChunk(ObjChunk& chunk, std::vector<Vector3>& positions, std::vector<Vector2>& UVs, std::vector<Vector3>& normals)
+		{
+			size_t positionCount{ chunk.firstRecords.positionCount };
+			size_t uvCount{ chunk.firstRecords.uvCount };
+			size_t normalCount{ chunk.firstRecords.normalCount };
+
+			//Faces are mostly triangles, polygons only grow the corners past what is reserved
+			chunk.corners.reserve(3 * chunk.counts.faceCount);
+			chunk.faceCornerCounts.reserve(chunk.counts.faceCount);
+
+			const char* pText{ chunk.pBegin };
+			const char* pEnd{ chunk.pEnd };
+
+			while (pText < pEnd)
+			{
+				pText = SkipSpaces(pText, pEnd);
+
+				if (IsRecord(pText, pEnd, "v"))
+				{
+					pText += 1;
+
+					Vector3 position{};
+					if (!ParseNumber(pText, pEnd, position.x) || !ParseNumber(pText, pEnd, position.y) || !ParseNumber(pText, pEnd, position.z))
+						return false;
+
+					positions[positionCount++] = position;
+				}
+				else if (IsRecord(pText, pEnd, "vt"))
+				{
+					pText += 2;
+
+					//v is optional
+					float u{}, v{};
+					if (!ParseNumber(pText, pEnd, u))
+						return false;
+
+					if (!IsLineEnd(SkipSpaces(pText, pEnd), pEnd) && !ParseNumber(pText, pEnd, v))
+						return false;
+
+					UVs[uvCount++] = Vector2{ u, 1 - v };
+				}
+				else if (IsRecord(pText, pEnd, "vn"))
+				{
+					pText += 2;
+
+					Vector3 normal{};
+					if (!ParseNumber(pText, pEnd, normal.x) || !ParseNumber(pText, pEnd, normal.y) || !ParseNumber(pText, pEnd, normal.z))
+						return false;
+
+					normals[normalCount++] = normal;
+				}
+				else if (IsRecord(pText, pEnd, "f"))
+				{
+					pText += 1;
+
+					uint32_t cornerCount{};
+
+					while (!IsLineEnd(pText = SkipSpaces(pText, pEnd), pEnd))
+					{
+						//p, p/t, p//n or p/t/n
+						ObjCorner corner{ 0, CornerVertexMap::None, CornerVertexMap::None };
+
+						if (!ParseIndex(pText, pEnd, positionCount, corner.position))
+							return false;
+
+						if (pText < pEnd && *pText == '/')
+						{
+							++pText;
+
+							if (pText < pEnd && *pText != '/' && !ParseIndex(pText, pEnd, uvCount, corner.uv))
+								return false;
+
+							if (pText < pEnd && *pText == '/')
+							{
+								++pText;
+
+								if (!ParseIndex(pText, pEnd, normalCount, corner.normal))
+									return false;
+							}
+						}
+
+						chunk.corners.push_back(corner);
+						++cornerCount;
+					}
+
+					chunk.faceCornerCounts.push_back(cornerCount);
+				}
+
+				//Comments, groups, materials and whatever is left of the line
+				pText = SkipLine(pText, pEnd);
+			}
+
+			return true;
+		}
+
+		//Entries of the cache the triangle order gets optimized for, about what the post transform caches of real gpus hold
+		constexpr int VertexCacheSize{ 32 };
+
+		//Tom Forsyth, Linear-Speed Vertex Cache Optimisation
+		//Vertices used recently score high so the next triangles reuse them while they are still cached,
+		//vertices with few triangles left score high so they get finished instead of having to be loaded again later
+		float GetVertexCacheScore(int cachePosition, uint32_t remainingTriangleCount)
+		{
+			if (remainingTriangleCount == 0)
+				return -1.f;
+
+			float score{};
+			if (cachePosition >= 0)
+			{
+				//The three vertices of the triangle just drawn score the same, no matter in which order they went in
+				if (cachePosition < 3)
+					score = .75f;
+				else
+					score = std::pow(1.f - static_cast<float>(cachePosition - 3) / (VertexCacheSize - 3), 1.5f);
+			}
+
+			return score + 2.f / std::sqrt(static_cast<float>(remainingTriangleCount));
+		}
+	}
+
+	MeshBounds Utils::CalculateBounds(std::span<const Vertex> vertices)
+	{
+		MeshBounds bounds{};
+		if (vertices.empty())
+			return bounds;
+
+		bounds.min = vertices[0].position;
+		bounds.max = vertices[0].position;
+
+		for (const Vertex& vertex : vertices)
+		{
+			for (int axis{}; axis < 3; ++axis)
+			{
+				bounds.min[axis] = std::min(bounds.min[axis], vertex.position[axis]);
+				bounds.max[axis] = std::max(bounds.max[axis], vertex.position[axis]);
+			}
+		}
+
+		bounds.center = (bounds.min + bounds.max) * .5f;
+
+		float sqrRadius{};
+		for (const Vertex& vertex : vertices)
+		{
+			sqrRadius = std::max(sqrRadius, (vertex.position - bounds.center).SqrMagnitude());
+		}
+		bounds.radius = std::sqrt(sqrRadius);
+
+		return bounds;
+	}
+
+	float Utils::CalculateACMR(std::span<const uint32_t> indices, size_t vertexCount, int cacheSize)
+	{
+		const size_t triangleCount{ indices.size() / 3 };
+		if (triangleCount == 0)
+			return 0.f;
+
+		//A vertex is still cached while fewer than cacheSize misses happened since its own, hits don't refresh it
+		std::vector<size_t> missTimes(vertexCount);
+		size_t time{ static_cast<size_t>(cacheSize) + 1 };
+		size_t missCount{};
+
+		for (const uint32_t index : indices)
+		{
+			if (time - missTimes[index] > static_cast<size_t>(cacheSize))
+			{
+				missTimes[index] = time++;
+				++missCount;
+			}
+		}
+
+		return static_cast<float>(missCount) / triangleCount;
+	}
+
+	void Utils::OptimizeVertexCache(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices)
+	{
+		constexpr uint32_t None{ UINT32_MAX };
+
+		const size_t vertexCount{ vertices.size() };
+		const size_t triangleCount{ indices.size() / 3 };
+		if (triangleCount == 0)
+			return;
+
+		//Triangles using each vertex, packed vertex after vertex, the ones still to be drawn in front
+		std::vector<uint32_t> firstVertexTriangles(vertexCount + 1);
+		for (size_t i{}; i < 3 * triangleCount; ++i)
+		{
+			++firstVertexTriangles[indices[i] + 1];
+		}
+		for (size_t vertex{}; vertex < vertexCount; ++vertex)
+		{
+			firstVertexTriangles[vertex + 1] += firstVertexTriangles[vertex];
+		}
+
+		std::vector<uint32_t> vertexTriangles(3 * triangleCount);
+		std::vector<uint32_t> remainingTriangleCounts(vertexCount);
+		for (size_t i{}; i < 3 * triangleCount; ++i)
+		{
+			const uint32_t vertex{ indices[i] };
+			vertexTriangles[firstVertexTriangles[vertex] + remainingTriangleCounts[vertex]++] = static_cast<uint32_t>(i / 3);
+		}
+
+		std::vector<int> cachePositions(vertexCount, -1);
+		std::vector<float> vertexScores(vertexCount);
+		for (size_t vertex{}; vertex < vertexCount; ++vertex)
+		{
+			vertexScores[vertex] = GetVertexCacheScore(-1, remainingTriangleCounts[vertex]);
+		}
+
+		std::vector<char> isTriangleDrawn(triangleCount);
+		std::vector<uint32_t> optimizedIndices{};
+		optimizedIndices.reserve(3 * triangleCount);
+
+		//Room for the three vertices a triangle pushes in, the ones falling out still need their score lowered
+		std::array<uint32_t, VertexCacheSize + 3> cache{};
+		std::array<uint32_t, VertexCacheSize + 3> newCache{};
+		int cacheCount{};
+
+		uint32_t bestTriangle{ None };
+		size_t nextUndrawnTriangle{};
+
+		for (size_t drawnCount{}; drawnCount < triangleCount; ++drawnCount)
+		{
+			//Nothing in the cache has a triangle left, carry on with the first one not drawn yet
+			if (bestTriangle == None)
+			{
+				while (isTriangleDrawn[nextUndrawnTriangle])
+					++nextUndrawnTriangle;
+
+				bestTriangle = static_cast<uint32_t>(nextUndrawnTriangle);
+			}
+
+			isTriangleDrawn[bestTriangle] = true;
+
+			int newCacheCount{};
+			for (int corner{}; corner < 3; ++corner)
+			{
+				const uint32_t vertex{ indices[3 * size_t{ bestTriangle } + corner] };
+				optimizedIndices.push_back(vertex);
+
+				//Move the triangle behind the vertex's remaining ones
+				uint32_t* pTriangles{ &vertexTriangles[firstVertexTriangles[vertex]] };
+				uint32_t& remainingCount{ remainingTriangleCounts[vertex] };
+				std::swap(*std::find(pTriangles, pTriangles + remainingCount, bestTriangle), pTriangles[remainingCount - 1]);
+				--remainingCount;
+
+				if (std::find(newCache.begin(), newCache.begin() + newCacheCount, vertex) == newCache.begin() + newCacheCount)
+					newCache[newCacheCount++] = vertex;
+			}
+
+			//The vertices of this triangle go to the front, everything else moves back
+			for (int i{}; i < cacheCount; ++i)
+			{
+				if (std::find(newCache.begin(), newCache.begin() + newCacheCount, cache[i]) == newCache.begin() + newCacheCount)
+					newCache[newCacheCount++] = cache[i];
+			}
+
+			for (int i{}; i < newCacheCount; ++i)
+			{
+				const uint32_t vertex{ newCache[i] };
+				cachePositions[vertex] = i < VertexCacheSize ? i : -1;
+				vertexScores[vertex] = GetVertexCacheScore(cachePositions[vertex], remainingTriangleCounts[vertex]);
+			}
+
+			cacheCount = std::min(newCacheCount, VertexCacheSize);
+			std::swap(cache, newCache);
+
+			//Only triangles touching the cache changed score, the best of them is drawn next
+			bestTriangle = None;
+			float bestScore{ -1.f };
+
+			for (int i{}; i < cacheCount; ++i)
+			{
+				const uint32_t vertex{ cache[i] };
+				const uint32_t* pTriangles{ &vertexTriangles[firstVertexTriangles[vertex]] };
+
+				for (uint32_t j{}; j < remainingTriangleCounts[vertex]; ++j)
+				{
+					const uint32_t* pIndices{ &indices[3 * size_t{ pTriangles[j] }] };
+					const float score{ vertexScores[pIndices[0]] + vertexScores[pIndices[1]] + vertexScores[pIndices[2]] };
+
+					if (score > bestScore)
+					{
+						bestScore = score;
+						bestTriangle = pTriangles[j];
+					}
+				}
+			}
+		}
+
+		//Number the vertices in the order the new triangles first use them, so vertex fetches mostly walk forward through memory
+		std::vector<uint32_t> newVertexIndices(vertexCount, None);
+		std::vector<Vertex> optimizedVertices{};
+		optimizedVertices.reserve(vertexCount);
+
+		for (uint32_t& index : optimizedIndices)
+		{
+			if (newVertexIndices[index] == None)
+			{
+				newVertexIndices[index] = static_cast<uint32_t>(optimizedVertices.size());
+				optimizedVertices.push_back(vertices[index]);
+			}
+
+			index = newVertexIndices[index];
+		}
+
+		//Vertices no triangle uses are kept, at the end
+		for (size_t vertex{}; vertex < vertexCount; ++vertex)
+		{
+			if (newVertexIndices[vertex] == None)
+				optimizedVertices.push_back(vertices[vertex]);
+		}
+
+		vertices = std::move(optimizedVertices);
+		indices = std::move(optimizedIndices);
+	}
+
+	bool Utils::ParseOBJ(const std::string& filename, std::vector<Vertex>& vertices, std::vector<uint32_t>& indices, bool flipAxisAndWinding, ThreadPool* pThreadPool)
+	{
+		constexpr size_t MinBytesPerChunk{ 64 * 1024 };
+
+		std::ifstream file(filename, std::ios::binary | std::ios::ate);
+		if (!file)
+			return false;
+
+		//One read for the whole file, parsing then only walks memory
+		std::vector<char> text(static_cast<size_t>(file.tellg()));
+		file.seekg(0);
+		if (!file.read(text.data(), static_cast<std::streamsize>(text.size())))
+			return false;
+
+		const char* pText{ text.data() };
+		const char* pEnd{ pText + text.size() };
+
+		vertices.clear();
+		indices.clear();
+
+		//A few chunks per thread, so a chunk heavy on faces doesn't keep the others waiting
+		const int chunkCount{ GetJobCount(pThreadPool, text.size(), MinBytesPerChunk, 4) };
+		std::vector<ObjChunk> chunks(chunkCount);
+
+		//Every chunk ends right behind a line end, no record is split between two of them
+		for (int i{}; i < chunkCount; ++i)
+		{
+			ObjChunk& chunk{ chunks[i] };
+			chunk.pBegin = i == 0 ? pText : chunks[i - 1].pEnd;
+			chunk.pEnd = i == chunkCount - 1 ? pEnd : std::max(chunk.pBegin, SkipLine(pText + GetRangeBegin(text.size(), chunkCount, i + 1), pEnd));
+		}
+
+		//Counting first tells every chunk where its records go, so they can all be parsed at once
+		RunJobs(pThreadPool, chunkCount, [&chunks](int i)
+			{
+				chunks[i].counts = CountRecords(chunks[i].pBegin, chunks[i].pEnd);
+			});
+
+		ObjRecordCounts counts{};
+		for (ObjChunk& chunk : chunks)
+		{
+			chunk.firstRecords = counts;
+
+			counts.positionCount += chunk.counts.positionCount;
+			counts.uvCount += chunk.counts.uvCount;
+			counts.normalCount += chunk.counts.normalCount;
+			counts.faceCount += chunk.counts.faceCount;
+		}
+
+		std::vector<Vector3> positions(counts.positionCount);
+		std::vector<Vector3> normals(counts.normalCount);
+		std::vector<Vector2> UVs(counts.uvCount);
+
+		//Not a vector<bool>, its elements would share bytes between jobs
+		std::vector<char> isChunkValid(chunkCount);
+		RunJobs(pThreadPool, chunkCount, [&](int i)
+			{
+				isChunkValid[i] = ParseChunk(chunks[i], positions, UVs, normals);
+			});
+
+		if (std::find(isChunkValid.begin(), isChunkValid.end(), char{ false }) != isChunkValid.end())
+			return false;
+
+		indices.reserve(3 * counts.faceCount);
+
+		//Every position, uv and normal is used by at least one vertex, usually not by many more
+		vertices.reserve(std::max(counts.positionCount, std::max(counts.uvCount, counts.normalCount)));
+
+		//Corners that repeat a position, uv and normal share one vertex, most are shared by several triangles
+		CornerVertexMap cornerVertices{ 3 * counts.faceCount };
+
+		//Chunk after chunk, so vertices get numbered in the order their corners appear in the file
+		for (const ObjChunk& chunk : chunks)
+		{
+			const ObjCorner* pCorner{ chunk.corners.data() };
+
+			for (const uint32_t cornerCount : chunk.faceCornerCounts)
+			{
+				//Corners after the third close a triangle with the first and the previous one
+				uint32_t firstIndex{};
+				uint32_t previousIndex{};
+
+				for (uint32_t cornerIdx{}; cornerIdx < cornerCount; ++cornerIdx, ++pCorner)
+				{
+					const uint32_t newIndex{ static_cast<uint32_t>(vertices.size()) };
+					const uint32_t index{ cornerVertices.FindOrInsert(pCorner->position, pCorner->uv, pCorner->normal, newIndex) };
+
+					if (index == newIndex)
+					{
+						Vertex vertex{};
+						vertex.position = positions[pCorner->position];
+						if (pCorner->uv != CornerVertexMap::None)
+							vertex.uv = UVs[pCorner->uv];
+						if (pCorner->normal != CornerVertexMap::None)
+							vertex.normal = normals[pCorner->normal];
+
+						vertices.push_back(vertex);
+					}
+
+					if (cornerIdx == 0)
+					{
+						firstIndex = index;
+					}
+					else if (cornerIdx >= 2)
+					{
+						indices.push_back(firstIndex);
+						if (flipAxisAndWinding)
+						{
+							indices.push_back(index);
+							indices.push_back(previousIndex);
+						}
+						else
+						{
+							indices.push_back(previousIndex);
+							indices.push_back(index);
+						}
+					}
+
+					previousIndex = index;
+				}
+			}
+		}
+
+		CalculateTangents(vertices, indices, flipAxisAndWinding, pThreadPool);
+
+		return true;
+	}
+
+	bool Utils::ParseOBJStream(const std::string& filename, std::vector<Vertex>& vertices, std::vector<uint32_t>& indices, bool flipAxisAndWinding)
+	{
+		std::ifstream file(filename);
+		if (!file)
+			return false;
+
+		std::vector<Vector3> positions{};
+		std::vector<Vector3> normals{};
+		std::vector<Vector2> UVs{};
+
+		vertices.clear();
+		indices.clear();
+
+		std::string sCommand;
+		// start a while iteration ending when the end of file is reached (ios::eof)
+		while (!file.eof())
+		{
+			//read the first word of the string, use the >> operator (istream::operator>>)
+			file >> sCommand;
+			//use conditional statements to process the different commands
+			if (sCommand == "#")
+			{
+				// Ignore Comment
+			}
+			else if (sCommand == "v")
+			{
+				//Vertex
+				float x, y, z;
+				file >> x >> y >> z;
+
+				positions.emplace_back(x, y, z);
+			}
+			else if (sCommand == "vt")
+			{
+				// Vertex TexCoord
+				float u, v;
+				file >> u >> v;
+				UVs.emplace_back(u, 1 - v);
+			}
+			else if (sCommand == "vn")
+			{
+				// Vertex Normal
+				float x, y, z;
+				file >> x >> y >> z;
+
+				normals.emplace_back(x, y, z);
+			}
+			else if (sCommand == "f")
+			{
+				//if a face is read:
+				//construct the 3 vertices, add them to the vertex array
+				//add three indices to the index array
+				//add the material index as attibute to the attribute array
+				//
+				// Faces or triangles
+				Vertex vertex{};
+				size_t iPosition, iTexCoord, iNormal;
+
+				uint32_t tempIndices[3];
+				for (size_t iFace = 0; iFace < 3; iFace++)
+				{
+					// OBJ format uses 1-based arrays
+					file >> iPosition;
+					vertex.position = positions[iPosition - 1];
+
+					if ('/' == file.peek())//is next in buffer ==  '/' ?
+					{
+						file.ignore();//read and ignore one element ('/')
+
+						if ('/' != file.peek())
+						{
+							// Optional texture coordinate
+							file >> iTexCoord;
+							vertex.uv = UVs[iTexCoord - 1];
+						}
+
+						if ('/' == file.peek())
+						{
+							file.ignore();
+
+							// Optional vertex normal
+							file >> iNormal;
+							vertex.normal = normals[iNormal - 1];
+						}
+					}
+
+					vertices.push_back(vertex);
+					tempIndices[iFace] = uint32_t(vertices.size()) - 1;
+					//indices.push_back(uint32_t(vertices.size()) - 1);
+				}
+
+				indices.push_back(tempIndices[0]);
+				if (flipAxisAndWinding)
+				{
+					indices.push_back(tempIndices[2]);
+					indices.push_back(tempIndices[1]);
+				}
+				else
+				{
+					indices.push_back(tempIndices[1]);
+					indices.push_back(tempIndices[2]);
+				}
+			}
+			//read till end of line and ignore all remaining chars
+			file.ignore(1000, '\n');
+		}
+
+		CalculateTangents(vertices, indices, flipAxisAndWinding, nullptr);
+
+		return true;
+	}
+}
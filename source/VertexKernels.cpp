@@ -0,0 +1,392 @@
+#include "VertexKernels.h"
+#include "CpuFeatures.h"
+#include "DataTypes.h"
+
+#include <algorithm>
+
+namespace dae
+{
+	namespace
+	{
+		constexpr int MaxLanes{ 8 };
+
+		//Results of one batch in SoA form, written back to the Vertex_Out array once the batch is done
+		struct TransformedBatch
+		{
+			alignas(32) float positionX[MaxLanes];
+			alignas(32) float positionY[MaxLanes];
+			alignas(32) float positionZ[MaxLanes];
+			alignas(32) float positionW[MaxLanes];
+
+			alignas(32) float normalX[MaxLanes];
+			alignas(32) float normalY[MaxLanes];
+			alignas(32) float normalZ[MaxLanes];
+
+			alignas(32) float tangentX[MaxLanes];
+			alignas(32) float tangentY[MaxLanes];
+			alignas(32) float tangentZ[MaxLanes];
+
+			alignas(32) float viewDirectionX[MaxLanes];
+			alignas(32) float viewDirectionY[MaxLanes];
+			alignas(32) float viewDirectionZ[MaxLanes];
+		};
+
+		//Color and uv don't get transformed, they are copied straight from the input vertices
+		void StoreBatch(const TransformedBatch& batch, const Vertex* pVertices, Vertex_Out* pVerticesOut, int count)
+		{
+			for (int lane{}; lane < count; ++lane)
+			{
+				Vertex_Out& vertexOut{ pVerticesOut[lane] };
+
+				vertexOut.position = { batch.positionX[lane], batch.positionY[lane], batch.positionZ[lane], batch.positionW[lane] };
+				vertexOut.color = pVertices[lane].color;
+				vertexOut.uv = pVertices[lane].uv;
+				vertexOut.normal = { batch.normalX[lane], batch.normalY[lane], batch.normalZ[lane] };
+				vertexOut.tangent = { batch.tangentX[lane], batch.tangentY[lane], batch.tangentZ[lane] };
+				vertexOut.viewDirection = { batch.viewDirectionX[lane], batch.viewDirectionY[lane], batch.viewDirectionZ[lane] };
+			}
+		}
+
+#if defined(DAE_X86)
+		//Every element of the matrix broadcast to all lanes, m[row][column]
+		struct MatrixSSE
+		{
+			__m128 m[4][4];
+		};
+
+		MatrixSSE BroadcastSSE(const Matrix& matrix)
+		{
+			MatrixSSE result{};
+			for (int row{}; row < 4; ++row)
+			{
+				for (int column{}; column < 4; ++column)
+				{
+					result.m[row][column] = _mm_set1_ps(matrix[row][column]);
+				}
+			}
+			return result;
+		}
+
+		//Moves the same float member of count (<= 4) consecutive vertices into one register
+		//Lanes past count repeat the last vertex so they never read past the array
+		__m128 LoadMemberSSE(const float* pFirstVertexMember, int count)
+		{
+			const auto member = [&](int lane)
+				{
+					const char* pMember{ reinterpret_cast<const char*>(pFirstVertexMember) + std::min(lane, count - 1) * sizeof(Vertex) };
+					return *reinterpret_cast<const float*>(pMember);
+				};
+
+			return _mm_setr_ps(member(0), member(1), member(2), member(3));
+		}
+
+		//Same order of operations as Matrix::TransformPoint and Matrix::TransformVector
+		__m128 TransformVectorSSE(const MatrixSSE& matrix, int column, __m128 x, __m128 y, __m128 z)
+		{
+			return _mm_add_ps(_mm_add_ps(_mm_mul_ps(matrix.m[0][column], x), _mm_mul_ps(matrix.m[1][column], y)), _mm_mul_ps(matrix.m[2][column], z));
+		}
+
+		__m128 TransformPointSSE(const MatrixSSE& matrix, int column, __m128 x, __m128 y, __m128 z)
+		{
+			return _mm_add_ps(TransformVectorSSE(matrix, column, x, y, z), matrix.m[3][column]);
+		}
+
+		//rcpps and rsqrtps are only good for 12 bits, one Newton-Raphson step brings them close to full precision
+		__m128 ReciprocalSSE(__m128 x)
+		{
+			const __m128 estimate{ _mm_rcp_ps(x) };
+			return _mm_mul_ps(estimate, _mm_sub_ps(_mm_set1_ps(2.0f), _mm_mul_ps(x, estimate)));
+		}
+
+		__m128 ReciprocalSqrtSSE(__m128 x)
+		{
+			const __m128 estimate{ _mm_rsqrt_ps(x) };
+			const __m128 xEstimateSquared{ _mm_mul_ps(_mm_mul_ps(x, estimate), estimate) };
+			return _mm_mul_ps(_mm_mul_ps(_mm_set1_ps(0.5f), estimate), _mm_sub_ps(_mm_set1_ps(3.0f), xEstimateSquared));
+		}
+
+		void NormalizeSSE(__m128& x, __m128& y, __m128& z)
+		{
+			const __m128 inverseLength{ ReciprocalSqrtSSE(_mm_add_ps(_mm_add_ps(_mm_mul_ps(x, x), _mm_mul_ps(y, y)), _mm_mul_ps(z, z))) };
+			x = _mm_mul_ps(x, inverseLength);
+			y = _mm_mul_ps(y, inverseLength);
+			z = _mm_mul_ps(z, inverseLength);
+		}
+
+		void TransformBatchSSE(const MatrixSSE& worldViewProjection, const MatrixSSE& world, const Vertex* pVertices, int count, TransformedBatch& batch)
+		{
+			//Position, to clip space and through the perspective divide, w is kept for the rasterizer
+			{
+				const __m128 x{ LoadMemberSSE(&pVertices->position.x, count) };
+				const __m128 y{ LoadMemberSSE(&pVertices->position.y, count) };
+				const __m128 z{ LoadMemberSSE(&pVertices->position.z, count) };
+
+				const __m128 w{ TransformPointSSE(worldViewProjection, 3, x, y, z) };
+				const __m128 inverseW{ ReciprocalSSE(w) };
+
+				_mm_store_ps(batch.positionX, _mm_mul_ps(TransformPointSSE(worldViewProjection, 0, x, y, z), inverseW));
+				_mm_store_ps(batch.positionY, _mm_mul_ps(TransformPointSSE(worldViewProjection, 1, x, y, z), inverseW));
+				_mm_store_ps(batch.positionZ, _mm_mul_ps(TransformPointSSE(worldViewProjection, 2, x, y, z), inverseW));
+				_mm_store_ps(batch.positionW, w);
+			}
+
+			{
+				const __m128 x{ LoadMemberSSE(&pVertices->normal.x, count) };
+				const __m128 y{ LoadMemberSSE(&pVertices->normal.y, count) };
+				const __m128 z{ LoadMemberSSE(&pVertices->normal.z, count) };
+
+				__m128 normalX{ TransformVectorSSE(world, 0, x, y, z) };
+				__m128 normalY{ TransformVectorSSE(world, 1, x, y, z) };
+				__m128 normalZ{ TransformVectorSSE(world, 2, x, y, z) };
+				NormalizeSSE(normalX, normalY, normalZ);
+
+				_mm_store_ps(batch.normalX, normalX);
+				_mm_store_ps(batch.normalY, normalY);
+				_mm_store_ps(batch.normalZ, normalZ);
+			}
+
+			{
+				const __m128 x{ LoadMemberSSE(&pVertices->tangent.x, count) };
+				const __m128 y{ LoadMemberSSE(&pVertices->tangent.y, count) };
+				const __m128 z{ LoadMemberSSE(&pVertices->tangent.z, count) };
+
+				__m128 tangentX{ TransformVectorSSE(world, 0, x, y, z) };
+				__m128 tangentY{ TransformVectorSSE(world, 1, x, y, z) };
+				__m128 tangentZ{ TransformVectorSSE(world, 2, x, y, z) };
+				NormalizeSSE(tangentX, tangentY, tangentZ);
+
+				_mm_store_ps(batch.tangentX, tangentX);
+				_mm_store_ps(batch.tangentY, tangentY);
+				_mm_store_ps(batch.tangentZ, tangentZ);
+			}
+
+			{
+				const __m128 x{ LoadMemberSSE(&pVertices->viewDirection.x, count) };
+				const __m128 y{ LoadMemberSSE(&pVertices->viewDirection.y, count) };
+				const __m128 z{ LoadMemberSSE(&pVertices->viewDirection.z, count) };
+
+				__m128 viewDirectionX{ TransformPointSSE(worldViewProjection, 0, x, y, z) };
+				__m128 viewDirectionY{ TransformPointSSE(worldViewProjection, 1, x, y, z) };
+				__m128 viewDirectionZ{ TransformPointSSE(worldViewProjection, 2, x, y, z) };
+				NormalizeSSE(viewDirectionX, viewDirectionY, viewDirectionZ);
+
+				_mm_store_ps(batch.viewDirectionX, viewDirectionX);
+				_mm_store_ps(batch.viewDirectionY, viewDirectionY);
+				_mm_store_ps(batch.viewDirectionZ, viewDirectionZ);
+			}
+		}
+
+		struct MatrixAVX2
+		{
+			__m256 m[4][4];
+		};
+
+		DAE_TARGET_AVX2 void BroadcastAVX2(const Matrix& matrix, MatrixAVX2& result)
+		{
+			for (int row{}; row < 4; ++row)
+			{
+				for (int column{}; column < 4; ++column)
+				{
+					result.m[row][column] = _mm256_set1_ps(matrix[row][column]);
+				}
+			}
+		}
+
+		//Same as LoadMemberSSE, but one gather with the vertex stride in bytes as offsets
+		DAE_TARGET_AVX2 __m256 LoadMemberAVX2(const float* pFirstVertexMember, int count)
+		{
+			const __m256i lanes{ _mm256_min_epi32(_mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7), _mm256_set1_epi32(count - 1)) };
+			const __m256i offsets{ _mm256_mullo_epi32(lanes, _mm256_set1_epi32(static_cast<int>(sizeof(Vertex)))) };
+
+			return _mm256_i32gather_ps(pFirstVertexMember, offsets, 1);
+		}
+
+		DAE_TARGET_AVX2 __m256 TransformVectorAVX2(const MatrixAVX2& matrix, int column, __m256 x, __m256 y, __m256 z)
+		{
+			return _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(matrix.m[0][column], x), _mm256_mul_ps(matrix.m[1][column], y)), _mm256_mul_ps(matrix.m[2][column], z));
+		}
+
+		DAE_TARGET_AVX2 __m256 TransformPointAVX2(const MatrixAVX2& matrix, int column, __m256 x, __m256 y, __m256 z)
+		{
+			return _mm256_add_ps(TransformVectorAVX2(matrix, column, x, y, z), matrix.m[3][column]);
+		}
+
+		DAE_TARGET_AVX2 __m256 ReciprocalAVX2(__m256 x)
+		{
+			const __m256 estimate{ _mm256_rcp_ps(x) };
+			return _mm256_mul_ps(estimate, _mm256_sub_ps(_mm256_set1_ps(2.0f), _mm256_mul_ps(x, estimate)));
+		}
+
+		DAE_TARGET_AVX2 __m256 ReciprocalSqrtAVX2(__m256 x)
+		{
+			const __m256 estimate{ _mm256_rsqrt_ps(x) };
+			const __m256 xEstimateSquared{ _mm256_mul_ps(_mm256_mul_ps(x, estimate), estimate) };
+			return _mm256_mul_ps(_mm256_mul_ps(_mm256_set1_ps(0.5f), estimate), _mm256_sub_ps(_mm256_set1_ps(3.0f), xEstimateSquared));
+		}
+
+		DAE_TARGET_AVX2 void NormalizeAVX2(__m256& x, __m256& y, __m256& z)
+		{
+			const __m256 inverseLength{ ReciprocalSqrtAVX2(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(x, x), _mm256_mul_ps(y, y)), _mm256_mul_ps(z, z))) };
+			x = _mm256_mul_ps(x, inverseLength);
+			y = _mm256_mul_ps(y, inverseLength);
+			z = _mm256_mul_ps(z, inverseLength);
+		}
+
+		DAE_TARGET_AVX2 void TransformBatchAVX2(const MatrixAVX2& worldViewProjection, const MatrixAVX2& world, const Vertex* pVertices, int count, TransformedBatch& batch)
+		{
+			{
+				const __m256 x{ LoadMemberAVX2(&pVertices->position.x, count) };
+				const __m256 y{ LoadMemberAVX2(&pVertices->position.y, count) };
+				const __m256 z{ LoadMemberAVX2(&pVertices->position.z, count) };
+
+				const __m256 w{ TransformPointAVX2(worldViewProjection, 3, x, y, z) };
+				const __m256 inverseW{ ReciprocalAVX2(w) };
+
+				_mm256_store_ps(batch.positionX, _mm256_mul_ps(TransformPointAVX2(worldViewProjection, 0, x, y, z), inverseW));
+				_mm256_store_ps(batch.positionY, _mm256_mul_ps(TransformPointAVX2(worldViewProjection, 1, x, y, z), inverseW));
+				_mm256_store_ps(batch.positionZ, _mm256_mul_ps(TransformPointAVX2(worldViewProjection, 2, x, y, z), inverseW));
+				_mm256_store_ps(batch.positionW, w);
+			}
+
+			{
+				const __m256 x{ LoadMemberAVX2(&pVertices->normal.x, count) };
+				const __m256 y{ LoadMemberAVX2(&pVertices->normal.y, count) };
+				const __m256 z{ LoadMemberAVX2(&pVertices->normal.z, count) };
+
+				__m256 normalX{ TransformVectorAVX2(world, 0, x, y, z) };
+				__m256 normalY{ TransformVectorAVX2(world, 1, x, y, z) };
+				__m256 normalZ{ TransformVectorAVX2(world, 2, x, y, z) };
+				NormalizeAVX2(normalX, normalY, normalZ);
+
+				_mm256_store_ps(batch.normalX, normalX);
+				_mm256_store_ps(batch.normalY, normalY);
+				_mm256_store_ps(batch.normalZ, normalZ);
+			}
+
+			{
+				const __m256 x{ LoadMemberAVX2(&pVertices->tangent.x, count) };
+				const __m256 y{ LoadMemberAVX2(&pVertices->tangent.y, count) };
+				const __m256 z{ LoadMemberAVX2(&pVertices->tangent.z, count) };
+
+				__m256 tangentX{ TransformVectorAVX2(world, 0, x, y, z) };
+				__m256 tangentY{ TransformVectorAVX2(world, 1, x, y, z) };
+				__m256 tangentZ{ TransformVectorAVX2(world, 2, x, y, z) };
+				NormalizeAVX2(tangentX, tangentY, tangentZ);
+
+				_mm256_store_ps(batch.tangentX, tangentX);
+				_mm256_store_ps(batch.tangentY, tangentY);
+				_mm256_store_ps(batch.tangentZ, tangentZ);
+			}
+
+			{
+				const __m256 x{ LoadMemberAVX2(&pVertices->viewDirection.x, count) };
+				const __m256 y{ LoadMemberAVX2(&pVertices->viewDirection.y, count) };
+				const __m256 z{ LoadMemberAVX2(&pVertices->viewDirection.z, count) };
+
+				__m256 viewDirectionX{ TransformPointAVX2(worldViewProjection, 0, x, y, z) };
+				__m256 viewDirectionY{ TransformPointAVX2(worldViewProjection, 1, x, y, z) };
+				__m256 viewDirectionZ{ TransformPointAVX2(worldViewProjection, 2, x, y, z) };
+				NormalizeAVX2(viewDirectionX, viewDirectionY, viewDirectionZ);
+
+				_mm256_store_ps(batch.viewDirectionX, viewDirectionX);
+				_mm256_store_ps(batch.viewDirectionY, viewDirectionY);
+				_mm256_store_ps(batch.viewDirectionZ, viewDirectionZ);
+			}
+		}
+#endif
+	}
+
+	void VertexKernels::TransformScalar(const Matrix& worldViewProjection, const Matrix& world, const Vertex* pVertices, Vertex_Out* pVerticesOut, int count)
+	{
+		for (int i{}; i < count; ++i)
+		{
+			const Vertex& vertex{ pVertices[i] };
+
+			Vertex_Out outVertex{ worldViewProjection.TransformPoint({vertex.position, 1.f})
+				, vertex.color, vertex.uv,
+				world.TransformVector(vertex.normal).Normalized(),
+				world.TransformVector(vertex.tangent).Normalized(),
+				worldViewProjection.TransformPoint(vertex.viewDirection).Normalized()
+			};
+
+			outVertex.position.x /= outVertex.position.w;
+			outVertex.position.y /= outVertex.position.w;
+			outVertex.position.z /= outVertex.position.w;
+
+			pVerticesOut[i] = outVertex;
+		}
+	}
+
+#if defined(DAE_X86)
+	void VertexKernels::TransformSSE(const Matrix& worldViewProjection, const Matrix& world, const Vertex* pVertices, Vertex_Out* pVerticesOut, int count)
+	{
+		const MatrixSSE worldViewProjectionSSE{ BroadcastSSE(worldViewProjection) };
+		const MatrixSSE worldSSE{ BroadcastSSE(world) };
+
+		TransformedBatch batch;
+
+		for (int i{}; i < count; i += 4)
+		{
+			const int batchCount{ std::min(count - i, 4) };
+
+			TransformBatchSSE(worldViewProjectionSSE, worldSSE, pVertices + i, batchCount, batch);
+			StoreBatch(batch, pVertices + i, pVerticesOut + i, batchCount);
+		}
+	}
+
+	DAE_TARGET_AVX2 void VertexKernels::TransformAVX2(const Matrix& worldViewProjection, const Matrix& world, const Vertex* pVertices, Vertex_Out* pVerticesOut, int count)
+	{
+		MatrixAVX2 worldViewProjectionAVX2;
+		MatrixAVX2 worldAVX2;
+		BroadcastAVX2(worldViewProjection, worldViewProjectionAVX2);
+		BroadcastAVX2(world, worldAVX2);
+
+		TransformedBatch batch;
+
+		for (int i{}; i < count; i += 8)
+		{
+			const int batchCount{ std::min(count - i, 8) };
+
+			TransformBatchAVX2(worldViewProjectionAVX2, worldAVX2, pVertices + i, batchCount, batch);
+			StoreBatch(batch, pVertices + i, pVerticesOut + i, batchCount);
+		}
+	}
+#else
+	void VertexKernels::TransformSSE(const Matrix& worldViewProjection, const Matrix& world, const Vertex* pVertices, Vertex_Out* pVerticesOut, int count)
+	{
+		TransformScalar(worldViewProjection, world, pVertices, pVerticesOut, count);
+	}
+
+	void VertexKernels::TransformAVX2(const Matrix& worldViewProjection, const Matrix& world, const Vertex* pVertices, Vertex_Out* pVerticesOut, int count)
+	{
+		TransformScalar(worldViewProjection, world, pVertices, pVerticesOut, count);
+	}
+#endif
+
+	VertexTransformKernel VertexKernels::SelectTransformKernel()
+	{
+#if defined(DAE_X86)
+		if (CpuFeatures::SupportsAVX2())
+			return &TransformAVX2;
+
+		//SSE2 is part of every x64 cpu
+		return &TransformSSE;
+#else
+		return &TransformScalar;
+#endif
+	}
+
+	const char* VertexKernels::GetKernelName(VertexTransformKernel kernel)
+	{
+#if defined(DAE_X86)
+		if (kernel == &TransformAVX2)
+			return "AVX2";
+		if (kernel == &TransformSSE)
+			return "SSE";
+#endif
+		if (kernel == &TransformScalar)
+			return "Scalar";
+
+		return "Unknown";
+	}
+}
@@ -0,0 +1,28 @@
+#pragma once
+
+namespace dae
+{
+	struct Matrix;
+	struct Vertex;
+	struct Vertex_Out;
+
+	//Transforms count vertices to ndc: position by worldViewProjection followed by the perspective divide,
+	//normal and tangent by world and the view direction by worldViewProjection, all three normalized
+	using VertexTransformKernel = void(*)(const Matrix& worldViewProjection, const Matrix& world, const Vertex* pVertices, Vertex_Out* pVerticesOut, int count);
+
+	namespace VertexKernels
+	{
+		//Exact, one vertex at a time
+		void TransformScalar(const Matrix& worldViewProjection, const Matrix& world, const Vertex* pVertices, Vertex_Out* pVerticesOut, int count);
+
+		//4 or 8 vertices at a time in SoA form, the divide and the normalizes use the reciprocal approximations
+		//refined by a Newton-Raphson step, which leaves them within a few ulp of the exact result
+		void TransformSSE(const Matrix& worldViewProjection, const Matrix& world, const Vertex* pVertices, Vertex_Out* pVerticesOut, int count);
+		void TransformAVX2(const Matrix& worldViewProjection, const Matrix& world, const Vertex* pVertices, Vertex_Out* pVerticesOut, int count);
+
+		//Picks the widest kernel the running cpu supports, falls back to the scalar one
+		VertexTransformKernel SelectTransformKernel();
+
+		const char* GetKernelName(VertexTransformKernel kernel);
+	}
+}
@@ -6,8 +6,11 @@
 
 //Standard includes
 #include <iostream>
+#include <string>
+#include <vector>
 
 //Project includes
+#include "Benchmark.h"
 #include "Timer.h"
 #include "Renderer.h"
 
@@ -19,11 +22,75 @@ void ShutDown(SDL_Window* pWindow)
 	SDL_Quit();
 }
 
+//Renders without a window or the video subsystem, for machines without a display
+int RunHeadless(bool runBenchmark)
+{
+	const int width = 640;
+	const int height = 480;
+
+	//The renderer draws straight into these
+	std::vector<uint32_t> colorBuffer(width * height);
+	std::vector<float> depthBuffer(width * height);
+
+	const auto pTimer = new Timer();
+	const auto pRenderer = new Renderer(colorBuffer.data(), depthBuffer.data(), width, height);
+
+	if (!pRenderer->IsInitialized())
+	{
+		delete pRenderer;
+		delete pTimer;
+
+		SDL_Quit();
+		return 1;
+	}
+
+	//Only the benchmark checks can fail
+	bool hasPassed{ true };
+
+	pTimer->Start();
+	if (runBenchmark)
+	{
+		Benchmark::RunTraversalBenchmark(*pRenderer, *pTimer);
+		Benchmark::RunVertexBenchmark();
+		Benchmark::RunTextureLayoutBenchmark(*pRenderer, *pTimer);
+		hasPassed = Benchmark::RunFastMathBenchmark(*pRenderer, *pTimer);
+		hasPassed = Benchmark::RunVertexCacheBenchmark(*pRenderer, *pTimer) && hasPassed;
+		hasPassed = Benchmark::RunObjLoaderBenchmark() && hasPassed;
+	}
+	else
+	{
+		pRenderer->Update(pTimer);
+		pRenderer->Render();
+
+		if (!pRenderer->SaveBufferToImage("Rasterizer_Headless.bmp"))
+			std::cout << "Frame saved to Rasterizer_Headless.bmp" << std::endl;
+		else
+			std::cout << "Something went wrong. Frame not saved!" << std::endl;
+	}
+	pTimer->Stop();
+
+	delete pRenderer;
+	delete pTimer;
+
+	SDL_Quit();
+	return hasPassed ? 0 : 1;
+}
+
 int main(int argc, char* args[])
 {
-	//Unreferenced parameters
-	(void)argc;
-	(void)args;
+	//Run the benchmarks instead of the interactive loop and/or render without a window when asked for
+	bool runBenchmark{ false };
+	bool runHeadless{ false };
+
+	for (int i{ 1 }; i < argc; ++i)
+	{
+		const std::string argument{ args[i] };
+		runBenchmark |= argument == "-benchmark";
+		runHeadless |= argument == "-headless";
+	}
+
+	if (runHeadless)
+		return RunHeadless(runBenchmark);
 
 	//Create window + surfaces
 	SDL_Init(SDL_INIT_VIDEO);
@@ -44,6 +111,33 @@ int main(int argc, char* args[])
 	const auto pTimer = new Timer();
 	const auto pRenderer = new Renderer(pWindow);
 
+	if (!pRenderer->IsInitialized())
+	{
+		delete pRenderer;
+		delete pTimer;
+
+		ShutDown(pWindow);
+		return 1;
+	}
+
+	if (runBenchmark)
+	{
+		pTimer->Start();
+		Benchmark::RunTraversalBenchmark(*pRenderer, *pTimer);
+		Benchmark::RunVertexBenchmark();
+		Benchmark::RunTextureLayoutBenchmark(*pRenderer, *pTimer);
+		bool hasPassed{ Benchmark::RunFastMathBenchmark(*pRenderer, *pTimer) };
+		hasPassed = Benchmark::RunVertexCacheBenchmark(*pRenderer, *pTimer) && hasPassed;
+		hasPassed = Benchmark::RunObjLoaderBenchmark() && hasPassed;
+		pTimer->Stop();
+
+		delete pRenderer;
+		delete pTimer;
+
+		ShutDown(pWindow);
+		return hasPassed ? 0 : 1;
+	}
+
 	//Start loop
 	pTimer->Start();
 	float printTimer = 0.f;
@@ -66,6 +160,18 @@ int main(int argc, char* args[])
 				case SDL_SCANCODE_X:
 					takeScreenshot = true;
 					break;
+				case SDL_SCANCODE_C:
+					pRenderer->CycleCullMode();
+					break;
+				case SDL_SCANCODE_M:
+					pRenderer->ToggleMesh();
+					break;
+				case SDL_SCANCODE_F1:
+					pRenderer->ToggleFastMath();
+					break;
+				case SDL_SCANCODE_F2:
+					pRenderer->TogglePackedMaterial();
+					break;
 				case SDL_SCANCODE_F3:
 					pRenderer->ToggleBoundingBox();
 					break;
@@ -81,6 +187,21 @@ int main(int argc, char* args[])
 				case SDL_SCANCODE_F7:
 					pRenderer->CycleShading();
 					break;
+				case SDL_SCANCODE_F8:
+					pRenderer->ToggleMultithreading();
+					break;
+				case SDL_SCANCODE_F9:
+					pRenderer->CycleRasterizerMode();
+					break;
+				case SDL_SCANCODE_F10:
+					pRenderer->ToggleHiZ();
+					break;
+				case SDL_SCANCODE_F11:
+					pRenderer->CycleRenderPath();
+					break;
+				case SDL_SCANCODE_F12:
+					pRenderer->CycleTextureFilter();
+					break;
 				default:
 					break;
 				}